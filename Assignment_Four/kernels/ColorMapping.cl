@@ -18,20 +18,27 @@ __constant Pixel black = {0.0f,0.0f,0.0f};
 __kernel void ColorMapping(
     __global char* background,
     write_only image2d_t tex,
-    const int numCols
+    const int numRows,
+    const int numCols,
+    const int displayWidth,
+    const int displayHeight
 )
 {
-    // Get the row and column this work-item will compute
+    // Get the display pixel this work-item will compute
     int row = get_global_id(0);
     int col = get_global_id(1);
+    if (row >= displayHeight || col >= displayWidth)
+        return;
+    // Nearest cell when the board is larger than the display
+    int cell = (int)((long)row * numRows / displayHeight) * numCols + (int)((long)col * numCols / displayWidth);
     int2 pos = (int2)(col,row);
     float4 color = (float4)(0.0f, 0.0f, 0.0f, 1.0f);
 
-    if ((int)background[row * numCols + col] != -1)
+    if ((int)background[cell] != -1)
         color = (float4)(
-            colorMapping[(int)background[row * numCols + col]].r,
-            colorMapping[(int)background[row * numCols + col]].g,
-            colorMapping[(int)background[row * numCols + col]].b,
+            colorMapping[(int)background[cell]].r,
+            colorMapping[(int)background[cell]].g,
+            colorMapping[(int)background[cell]].b,
             1.0f 
         );
     
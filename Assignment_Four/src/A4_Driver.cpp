@@ -4,11 +4,14 @@
 #include "CL/cl_gl.h"
 #include "glad/glad.h"
 #include "GLFW/glfw3.h"
+#include "Options.h"
+#include "Rng.h"
+#include "Digest.h"
+#include "Viewport.h"
+#include "Throughput.h"
 #include <windows.h>
 #include <GL/gl.h>
 #include <iostream>
-#include <cstdlib>
-#include <ctime>
 #include <utility>
 #include <chrono>
 #include <vector>
@@ -19,11 +22,13 @@
 #ifndef KERNEL_DIR
 #define KERNEL_DIR "../kernels"
 #endif
+#ifndef COMMON_INCLUDE_DIR
+#define COMMON_INCLUDE_DIR "../../Common/include"
+#endif
 
 struct Pixel {float r, g, b;};
 const int WIDTH = 1024;
 const int HEIGHT = 768;
-Pixel display[HEIGHT * WIDTH];
 
 const char* vertexShaderSource = R"(
 #version 330 core
@@ -94,19 +99,31 @@ void FramesPerSecondPrint(int& frames, std::chrono::high_resolution_clock::time_
     }
 }
 
-int main(){
+int main(int argc, char** argv){
+    Options options = parseOptions(argc, argv);
     double targetFPS = 500;
 
     using clock = std::chrono::high_resolution_clock;
-    srand(static_cast<unsigned>(time(0)));
-    
-    int8_t numSpecies = 5 + rand() % 6;
-    static int8_t foreground[HEIGHT * WIDTH];
-    static int8_t background[HEIGHT * WIDTH];
+    cl_ulong seed = options.seed;
+    cl_ulong generation = 0;
+    std::cout << "Seed: " << seed << "\n";
+
+    int numRows = options.height > 0 ? options.height : HEIGHT;
+    int numCols = options.width > 0 ? options.width : WIDTH;
+    int8_t numSpecies = options.species > 0 ? static_cast<int8_t>(options.species) : 5 + static_cast<int8_t>(rngMix(seed) % 6);
+    int torus = options.boundary == Boundary::Torus;
+    if (options.threads > 0)
+        std::cerr << "--threads has no effect on the OpenCL backend\n";
+
+    // Boards larger than the window are sampled down, small ones are scaled up by the window
+    int displayWidth, displayHeight, windowWidth, windowHeight;
+    fitInside(numCols, numRows, WIDTH, HEIGHT, false, displayWidth, displayHeight);
+    fitInside(displayWidth, displayHeight, WIDTH, HEIGHT, true, windowWidth, windowHeight);
+    std::vector<int8_t> foreground(static_cast<size_t>(numRows) * numCols);
+    std::vector<int8_t> background(foreground.size());
 
     int frames = 0;
     double fps = 0.0;
-    int randomNum = rand();
 
     cl_device_id device_gpu;
     cl_device_id device_cpu;
@@ -119,88 +136,97 @@ int main(){
     cl_mem clForeground;
     cl_mem clBackground;
     cl_mem clDisplay;
-    size_t szGlobalWorkSize[2] = { HEIGHT, WIDTH }; // Global # of work items
-    size_t szLocalWorkSize[2] = { 1,1 }; // # of Work Items in Work Group
+    // --tile sets the edge of a work group, the global range is rounded up to whole groups
+    // and the kernels skip the work-items that fall off the board
+    size_t tile = options.tile > 0 ? static_cast<size_t>(options.tile) : 1;
+    size_t szGlobalWorkSize[2] = { (numRows + tile - 1) / tile * tile, (numCols + tile - 1) / tile * tile }; // Global # of work items
+    size_t szColorWorkSize[2] = { (displayHeight + tile - 1) / tile * tile, (displayWidth + tile - 1) / tile * tile };
+    size_t szLocalWorkSize[2] = { tile, tile }; // # of Work Items in Work Group
     cl_event checkArrayEvent;
     cl_uint num_device_returned;
     cl_platform_id selectedPlatform = nullptr;
 
     // Initialize our buffers with random values
-    for (int row = 0; row < HEIGHT; row++){
-        for (int col = 0; col < WIDTH; col++){
-            foreground[row * WIDTH + col] = rand() % numSpecies;
-            background[row * WIDTH + col] = foreground[row * WIDTH + col];
+    for (int row = 0; row < numRows; row++){
+        for (int col = 0; col < numCols; col++){
+            foreground[static_cast<size_t>(row) * numCols + col] = initialState(seed, row, col, numSpecies);
+            background[static_cast<size_t>(row) * numCols + col] = foreground[static_cast<size_t>(row) * numCols + col];
         }
     }
+    if (options.generations > 0)
+        printDigest(0, boardDigest(foreground.data(), numRows, numCols));
+
+    // --headless never touches GLFW or GL, the kernels draw into a plain image on the device instead
+    GLFWwindow* window = nullptr;
+    GLuint tex = 0, VAO = 0, VBO = 0, EBO = 0, shaderProgram = 0;
+    if (!options.headless){
+        // Initialize GLFW
+        if (!glfwInit()) return -1;
+        glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
+        glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
+        glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+
+        window = glfwCreateWindow(windowWidth, windowHeight, "Game of Life", nullptr, nullptr);
+        if (!window) { glfwTerminate(); return -1; }
+        glfwMakeContextCurrent(window);
+        glfwSwapInterval(0);
+
+        if (!gladLoadGLLoader((GLADloadproc)glfwGetProcAddress)) {
+            std::cerr << "Failed to initialize GLAD\n";
+            return -1;
+        }
 
-    // Initialize GLFW
-    if (!glfwInit()) return -1;
-    glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
-    glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
-    glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
-
-    GLFWwindow* window = glfwCreateWindow(WIDTH, HEIGHT, "Game of Life", nullptr, nullptr);
-    if (!window) { glfwTerminate(); return -1; }
-    glfwMakeContextCurrent(window);
-    glfwSwapInterval(0);
+        // Create texture
+        glGenTextures(1, &tex);
+        glBindTexture(GL_TEXTURE_2D, tex);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+        glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA32F, displayWidth, displayHeight, 0, GL_RGBA, GL_FLOAT, NULL);
+
+        // Quad vertices
+        float quadVertices[] = {
+            // positions    // texCoords
+            -1.0f,  1.0f,   0.0f, 1.0f,
+            -1.0f, -1.0f,   0.0f, 0.0f,
+             1.0f, -1.0f,   1.0f, 0.0f,
+             1.0f,  1.0f,   1.0f, 1.0f
+        };
+        unsigned int indices[] = { 0, 1, 2, 0, 2, 3 };
+
+        glGenVertexArrays(1, &VAO);
+        glGenBuffers(1, &VBO);
+        glGenBuffers(1, &EBO);
 
-    if (!gladLoadGLLoader((GLADloadproc)glfwGetProcAddress)) {
-        std::cerr << "Failed to initialize GLAD\n";
-        return -1;
+        glBindVertexArray(VAO);
+        glBindBuffer(GL_ARRAY_BUFFER, VBO);
+        glBufferData(GL_ARRAY_BUFFER, sizeof(quadVertices), quadVertices, GL_STATIC_DRAW);
+
+        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO);
+        glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(indices), indices, GL_STATIC_DRAW);
+
+        // Position
+        glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, 4 * sizeof(float), (void*)0);
+        glEnableVertexAttribArray(0);
+        // TexCoord
+        glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, 4 * sizeof(float), (void*)(2 * sizeof(float)));
+        glEnableVertexAttribArray(1);
+
+        // Compile shaders
+        GLuint vertexShader = compileShader(GL_VERTEX_SHADER, vertexShaderSource);
+        GLuint fragmentShader = compileShader(GL_FRAGMENT_SHADER, fragmentShaderSource);
+        shaderProgram = glCreateProgram();
+        glAttachShader(shaderProgram, vertexShader);
+        glAttachShader(shaderProgram, fragmentShader);
+        glLinkProgram(shaderProgram);
+        glDeleteShader(vertexShader);
+        glDeleteShader(fragmentShader);
+
+        glUseProgram(shaderProgram);
+        glUniform1i(glGetUniformLocation(shaderProgram, "uTexture"), 0);
     }
 
-    // Create texture
-    GLuint tex;
-    glGenTextures(1, &tex);
-    glBindTexture(GL_TEXTURE_2D, tex);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
-    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA32F, WIDTH, HEIGHT, 0, GL_RGBA, GL_FLOAT, NULL);
-
-    // Quad vertices
-    float quadVertices[] = {
-        // positions    // texCoords
-        -1.0f,  1.0f,   0.0f, 1.0f,
-        -1.0f, -1.0f,   0.0f, 0.0f,
-         1.0f, -1.0f,   1.0f, 0.0f,
-         1.0f,  1.0f,   1.0f, 1.0f
-    };
-    unsigned int indices[] = { 0, 1, 2, 0, 2, 3 };
-
-    GLuint VAO, VBO, EBO;
-    glGenVertexArrays(1, &VAO);
-    glGenBuffers(1, &VBO);
-    glGenBuffers(1, &EBO);
-
-    glBindVertexArray(VAO);
-    glBindBuffer(GL_ARRAY_BUFFER, VBO);
-    glBufferData(GL_ARRAY_BUFFER, sizeof(quadVertices), quadVertices, GL_STATIC_DRAW);
-
-    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO);
-    glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(indices), indices, GL_STATIC_DRAW);
-
-    // Position
-    glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, 4 * sizeof(float), (void*)0);
-    glEnableVertexAttribArray(0);
-    // TexCoord
-    glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, 4 * sizeof(float), (void*)(2 * sizeof(float)));
-    glEnableVertexAttribArray(1);
-
-    // Compile shaders
-    GLuint vertexShader = compileShader(GL_VERTEX_SHADER, vertexShaderSource);
-    GLuint fragmentShader = compileShader(GL_FRAGMENT_SHADER, fragmentShaderSource);
-    GLuint shaderProgram = glCreateProgram();
-    glAttachShader(shaderProgram, vertexShader);
-    glAttachShader(shaderProgram, fragmentShader);
-    glLinkProgram(shaderProgram);
-    glDeleteShader(vertexShader);
-    glDeleteShader(fragmentShader);
-
-    glUseProgram(shaderProgram);
-    glUniform1i(glGetUniformLocation(shaderProgram, "uTexture"), 0);
-
     cl_uint numPlatforms1;
     clGetPlatformIDs(0, NULL, &numPlatforms1);
 
@@ -256,7 +282,8 @@ int main(){
     0
     };
 
-    context = clCreateContext(properties, 1, &device_gpu, NULL, NULL, &ciErrNum);
+    cl_context_properties headlessProperties[] = { CL_CONTEXT_PLATFORM, (cl_context_properties)selectedPlatform, 0 };
+    context = clCreateContext(options.headless ? headlessProperties : properties, 1, &device_gpu, NULL, NULL, &ciErrNum);
     if(ciErrNum != CL_SUCCESS) {
         std::cerr << "Failed to create OpenCL context\n";
     }
@@ -269,8 +296,8 @@ int main(){
     // Create our buffers
     clForeground = clCreateBuffer(context,
         CL_MEM_READ_WRITE | CL_MEM_COPY_HOST_PTR,
-        WIDTH * HEIGHT * sizeof(int8_t),
-        foreground,
+        foreground.size() * sizeof(int8_t),
+        foreground.data(),
         &ciErrNum
     );
     if(ciErrNum != CL_SUCCESS) {
@@ -279,24 +306,38 @@ int main(){
 
     clBackground = clCreateBuffer(context,
         CL_MEM_READ_WRITE | CL_MEM_COPY_HOST_PTR,
-        WIDTH * HEIGHT * sizeof(int8_t),
-        background,
+        background.size() * sizeof(int8_t),
+        background.data(),
         &ciErrNum
     );
     if(ciErrNum != CL_SUCCESS) {
         std::cerr << "Failed to create OpenCL buffer from background\n";
     }
 
-    clDisplay = clCreateFromGLTexture(
-        context,
-        CL_MEM_READ_WRITE,
-        GL_TEXTURE_2D,
-        0,
-        tex,
-        &ciErrNum
-    );
-    if (ciErrNum != CL_SUCCESS) {
-        std::cerr << "Failed to create OpenCL buffer from GL texture: " << ciErrNum << "\n";
+    if (options.headless){
+        // Same format as the GL texture, so ColorMapping.cl runs unchanged
+        cl_image_format format = { CL_RGBA, CL_FLOAT };
+        cl_image_desc desc = {};
+        desc.image_type = CL_MEM_OBJECT_IMAGE2D;
+        desc.image_width = displayWidth;
+        desc.image_height = displayHeight;
+        clDisplay = clCreateImage(context, CL_MEM_WRITE_ONLY, &format, &desc, NULL, &ciErrNum);
+        if (ciErrNum != CL_SUCCESS) {
+            std::cerr << "Failed to create OpenCL image for the display: " << ciErrNum << "\n";
+        }
+    }
+    else{
+        clDisplay = clCreateFromGLTexture(
+            context,
+            CL_MEM_READ_WRITE,
+            GL_TEXTURE_2D,
+            0,
+            tex,
+            &ciErrNum
+        );
+        if (ciErrNum != CL_SUCCESS) {
+            std::cerr << "Failed to create OpenCL buffer from GL texture: " << ciErrNum << "\n";
+        }
     }
 
     //cl_mem clPipe = clCreatePipe(
@@ -322,7 +363,9 @@ int main(){
     if (ciErrNum != CL_SUCCESS) {
         std::cerr << "Failed to create program\n";
     }
-    ciErrNum = clBuildProgram(program, 0, NULL, NULL, NULL, NULL);
+    // Lets CheckArray.cl include Rng.h
+    std::string buildOptions = "-I \"" + std::string(COMMON_INCLUDE_DIR) + "\"";
+    ciErrNum = clBuildProgram(program, 0, NULL, buildOptions.c_str(), NULL, NULL);
     if (ciErrNum != CL_SUCCESS) {
         std::cerr << "Failed to build program\n";
     }
@@ -351,31 +394,90 @@ int main(){
     if (ciErrNum != CL_SUCCESS) {
         std::cerr << "Failed to set kernel arg 2\n";
     }
-    ciErrNum = clSetKernelArg(CheckArrayKernel, 2, sizeof(int), &WIDTH);
+    ciErrNum = clSetKernelArg(CheckArrayKernel, 2, sizeof(int), &numRows);
     if (ciErrNum != CL_SUCCESS) {
         std::cerr << "Failed to set kernel arg 3\n";
     }
-    ciErrNum = clSetKernelArg(CheckArrayKernel, 3, sizeof(int8_t), &numSpecies);
+    ciErrNum = clSetKernelArg(CheckArrayKernel, 3, sizeof(int), &numCols);
     if (ciErrNum != CL_SUCCESS) {
         std::cerr << "Failed to set kernel arg 4\n";
     }
-    ciErrNum = clSetKernelArg(CheckArrayKernel, 4, sizeof(int), &randomNum);
+    ciErrNum = clSetKernelArg(CheckArrayKernel, 4, sizeof(int8_t), &numSpecies);
     if (ciErrNum != CL_SUCCESS) {
         std::cerr << "Failed to set kernel arg 5\n";
     }
-    ciErrNum = clSetKernelArg(ColorMappingKernel, 0, sizeof(cl_mem), &clBackground);
+    ciErrNum = clSetKernelArg(CheckArrayKernel, 5, sizeof(cl_ulong), &seed);
     if (ciErrNum != CL_SUCCESS) {
         std::cerr << "Failed to set kernel arg 6\n";
     }
-    ciErrNum = clSetKernelArg(ColorMappingKernel, 1, sizeof(cl_mem), &clDisplay);
+    ciErrNum = clSetKernelArg(CheckArrayKernel, 6, sizeof(cl_ulong), &generation);
     if (ciErrNum != CL_SUCCESS) {
         std::cerr << "Failed to set kernel arg 7\n";
     }
-    ciErrNum = clSetKernelArg(ColorMappingKernel, 2, sizeof(int), &WIDTH);
+    ciErrNum = clSetKernelArg(CheckArrayKernel, 7, sizeof(int), &torus);
     if (ciErrNum != CL_SUCCESS) {
         std::cerr << "Failed to set kernel arg 8\n";
     }
+    ciErrNum = clSetKernelArg(ColorMappingKernel, 0, sizeof(cl_mem), &clBackground);
+    if (ciErrNum != CL_SUCCESS) {
+        std::cerr << "Failed to set kernel arg 9\n";
+    }
+    ciErrNum = clSetKernelArg(ColorMappingKernel, 1, sizeof(cl_mem), &clDisplay);
+    if (ciErrNum != CL_SUCCESS) {
+        std::cerr << "Failed to set kernel arg 10\n";
+    }
+    ciErrNum = clSetKernelArg(ColorMappingKernel, 2, sizeof(int), &numRows);
+    if (ciErrNum != CL_SUCCESS) {
+        std::cerr << "Failed to set kernel arg 11\n";
+    }
+    ciErrNum = clSetKernelArg(ColorMappingKernel, 3, sizeof(int), &numCols);
+    if (ciErrNum != CL_SUCCESS) {
+        std::cerr << "Failed to set kernel arg 12\n";
+    }
+    ciErrNum = clSetKernelArg(ColorMappingKernel, 4, sizeof(int), &displayWidth);
+    if (ciErrNum != CL_SUCCESS) {
+        std::cerr << "Failed to set kernel arg 13\n";
+    }
+    ciErrNum = clSetKernelArg(ColorMappingKernel, 5, sizeof(int), &displayHeight);
+    if (ciErrNum != CL_SUCCESS) {
+        std::cerr << "Failed to set kernel arg 14\n";
+    }
 
+    if (options.headless){
+        StepTimes steps;
+        while (generation < static_cast<cl_ulong>(options.generations)){
+            auto start = clock::now();
+            clEnqueueNDRangeKernel(queue_gpu, CheckArrayKernel, 2, NULL, szGlobalWorkSize, szLocalWorkSize, 0, NULL, &checkArrayEvent);
+            clEnqueueNDRangeKernel(queue_gpu, ColorMappingKernel, 2, NULL, szColorWorkSize, szLocalWorkSize, 1, &checkArrayEvent, NULL);
+            clReleaseEvent(checkArrayEvent);
+            std::swap(clBackground, clForeground);
+            generation++;
+            ciErrNum = clSetKernelArg(CheckArrayKernel, 6, sizeof(cl_ulong), &generation);
+            ciErrNum = clSetKernelArg(CheckArrayKernel, 0, sizeof(cl_mem), &clForeground);
+            ciErrNum = clSetKernelArg(CheckArrayKernel, 1, sizeof(cl_mem), &clBackground);
+            ciErrNum = clSetKernelArg(ColorMappingKernel, 0, sizeof(cl_mem), &clBackground);
+            // Waiting on every generation gives each its own step time
+            clFinish(queue_gpu);
+            std::chrono::duration<double> elapsed = clock::now() - start;
+            steps.add(elapsed.count());
+        }
+        ciErrNum = clEnqueueReadBuffer(queue_gpu, clForeground, CL_TRUE, 0, foreground.size() * sizeof(int8_t), foreground.data(), 0, NULL, NULL);
+        if (ciErrNum != CL_SUCCESS) {
+            std::cerr << "Failed to read board for digest\n";
+        }
+        printDigest(generation, boardDigest(foreground.data(), numRows, numCols));
+        printThroughput(steps, numRows, numCols);
+
+        clReleaseMemObject(clForeground);
+        clReleaseMemObject(clBackground);
+        clReleaseMemObject(clDisplay);
+        clReleaseKernel(CheckArrayKernel);
+        clReleaseKernel(ColorMappingKernel);
+        clReleaseProgram(program);
+        clReleaseCommandQueue(queue_gpu);
+        clReleaseContext(context);
+        return 0;
+    }
 
     // Flush GL queue
     glFlush();
@@ -385,7 +487,7 @@ int main(){
         std::cerr << "Failed to acquire GL object: " << ciErrNum << "\n";
     }
 
-    ciErrNum = clEnqueueNDRangeKernel(queue_gpu, ColorMappingKernel, 2, NULL, szGlobalWorkSize, szLocalWorkSize, 0, NULL, NULL);
+    ciErrNum = clEnqueueNDRangeKernel(queue_gpu, ColorMappingKernel, 2, NULL, szColorWorkSize, szLocalWorkSize, 0, NULL, NULL);
     if (ciErrNum != CL_SUCCESS) {
         std::cerr << "Failed to Enqueue kernel\n";
     }
@@ -402,10 +504,6 @@ int main(){
         std::cerr << "ERROR ON CLFINISH()\n";
     }
 
-    std::swap(clBackground, clForeground);
-    randomNum = rand();
-    ciErrNum = clSetKernelArg(CheckArrayKernel, 4, sizeof(int), &randomNum);
-
     // Do initial drawing
     glClear(GL_COLOR_BUFFER_BIT);
     glBindTexture(GL_TEXTURE_2D, tex);
@@ -421,7 +519,8 @@ int main(){
     // Indicates the last time we displayed FPS
     auto lastFpsDisplay = clock::now();
     // Main loop
-    while (!glfwWindowShouldClose(window)) {
+    // A run with --generations stops on its own after the last one
+    while (!glfwWindowShouldClose(window) && (options.generations == 0 || generation < static_cast<cl_ulong>(options.generations))) {
         // Flush GL queue
         glFlush();
         // Acquire shared objects
@@ -434,7 +533,7 @@ int main(){
         if (ciErrNum != CL_SUCCESS) {
             std::cerr << "Failed to Enqueue kernel (CheckArrayKernel)\n";
         }
-        ciErrNum = clEnqueueNDRangeKernel(queue_gpu, ColorMappingKernel, 2, NULL, szGlobalWorkSize, szLocalWorkSize, 1, &checkArrayEvent, NULL);
+        ciErrNum = clEnqueueNDRangeKernel(queue_gpu, ColorMappingKernel, 2, NULL, szColorWorkSize, szLocalWorkSize, 1, &checkArrayEvent, NULL);
         if (ciErrNum != CL_SUCCESS) {
             std::cerr << "Failed to Enqueue kernel (ColorMappingKernel)\n";
         } 
@@ -453,9 +552,18 @@ int main(){
 
         std::swap(clBackground, clForeground);
 
+        // The newest board is in clForeground after the swap, read it back only to digest it
+        generation++;
+        if (options.generations > 0){
+            ciErrNum = clEnqueueReadBuffer(queue_gpu, clForeground, CL_TRUE, 0, foreground.size() * sizeof(int8_t), foreground.data(), 0, NULL, NULL);
+            if (ciErrNum != CL_SUCCESS) {
+                std::cerr << "Failed to read board for digest\n";
+            }
+            printDigest(generation, boardDigest(foreground.data(), numRows, numCols));
+        }
+
         // Set kernel arguments
-        randomNum = rand();
-        ciErrNum = clSetKernelArg(CheckArrayKernel, 4, sizeof(int), &randomNum);
+        ciErrNum = clSetKernelArg(CheckArrayKernel, 6, sizeof(cl_ulong), &generation);
         ciErrNum = clSetKernelArg(CheckArrayKernel, 0, sizeof(cl_mem), &clForeground);
         ciErrNum = clSetKernelArg(CheckArrayKernel, 1, sizeof(cl_mem), &clBackground);
         ciErrNum = clSetKernelArg(ColorMappingKernel, 0, sizeof(cl_mem), &clBackground);
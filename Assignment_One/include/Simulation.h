@@ -0,0 +1,103 @@
+#pragma once
+#include "Grid.h"
+#include "BitplaneBoard.h"
+#include "CellTexture.h"
+#include "PackedGrid.h"
+#include "DirtyTiles.h"
+#include "Options.h"
+#include "Palette.h"
+#include "ThreadPool.h"
+#include "TileDeque.h"
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <vector>
+
+int check(const Grid& foreground, Grid& background, const std::ptrdiff_t neighbors[8], int row, int col, int numSpecies, uint64_t seed, uint64_t generation);
+void decide(const Grid& foreground, Grid& background, int rowStart, int rowEnd, int colStart, int colEnd, int numSpecies, uint64_t seed, uint64_t generation);
+// decide() that also colours each cell it writes, into a display the size of the board
+void decideAndColor(const Grid& foreground, Grid& background, Pixel* display, int rowStart, int rowEnd, int colStart, int colEnd, int numSpecies, uint64_t seed, uint64_t generation);
+
+// Colours display pixels [rowStart, rowEnd) x [colStart, colEnd), pixel (i, j) shows cell (sampleRows[i], sampleCols[j])
+void numToColorMapping(const Grid& background, Pixel* display, const std::vector<int>& sampleRows, const std::vector<int>& sampleCols, int rowStart, int rowEnd, int colStart, int colEnd);
+void numToColorMapping(const PackedGrid& background, Pixel* display, const std::vector<int>& sampleRows, const std::vector<int>& sampleCols, int rowStart, int rowEnd, int colStart, int colEnd);
+
+// Owns both boards and advances them on the pool with the selected engine.
+// The board is cut into square tiles (64 cells by default) that the workers share out by schedule,
+// with skipStable only the tiles next to a change are recomputed and redrawn.
+class Simulation {
+    private:
+        ThreadPool& pool;
+        Engine engine;
+        Boundary boundary;
+        Schedule schedule;
+        int rows;
+        int cols;
+        int numSpecies;
+        std::vector<TileDeque> deques;  // one per worker, for Schedule::Steal
+        DirtyTiles tiles;
+        const std::vector<int>* activeTiles;
+        std::vector<std::vector<uint8_t> > staleTiles;  // per display image, the tiles changed since it was drawn
+        std::vector<int> drawnTiles;    // the tiles colorMap() redraws
+        std::unique_ptr<Grid> gridA;
+        std::unique_ptr<Grid> gridB;
+        Grid* foreground;
+        Grid* background;
+        std::unique_ptr<BitplaneBoard> planesA;
+        std::unique_ptr<BitplaneBoard> planesB;
+        BitplaneBoard* planeForeground;
+        BitplaneBoard* planeBackground;
+        std::unique_ptr<PackedGrid> packedA;
+        std::unique_ptr<PackedGrid> packedB;
+        PackedGrid* packedForeground;
+        PackedGrid* packedBackground;
+        uint64_t seed;
+        uint64_t generation;
+        Pixel* display;
+        std::vector<int> sampleRows;
+        std::vector<int> sampleCols;
+        std::vector<int> tileRowStarts;     // first display row and column of every tile
+        std::vector<int> tileColStarts;
+        std::function<void(int, int)> decidePhase;
+        std::function<void(int, int)> colorPhase;
+        bool fusing;    // stepTile() colours each tile it steps, set by stepAndColorMap()
+
+        void stepTile(int tile);
+        void colorTile(int tile, const Grid* board, const PackedGrid* packedBoard);
+        // Marks the tiles changed by the last step stale in every image, then redraws the stale ones of image
+        void markChanged();
+        void drawStale(int image);
+
+    public:
+        // With firstTouch the byte boards are filled by the workers, each its own row band, so on a
+        // pinned pool every band lands on the node of the worker that steps it
+        Simulation(ThreadPool& pool, int rows, int cols, int numSpecies, Engine engine, Boundary boundary, uint64_t seed, int tileSize = 0, bool skipStable = true, bool firstTouch = false, Schedule schedule = Schedule::Steal);
+
+        // Current generation, fill it and call reset() before the first step.
+        // The packed engine only copies its board back here in syncBoard().
+        Grid& board() { return *foreground; }
+        void syncBoard();
+        uint64_t generationCount() const { return generation; }
+        uint64_t digest();
+        // Where the board pages are and how fast each node's workers read their row bands
+        void printNodeReport();
+
+        void reset();
+        void step();
+        // Jumps to the given generation with the HashLife engine, which only knows the dead border;
+        // on a torus it steps there one generation at a time
+        void fastForward(uint64_t target);
+        // colorMap() draws the board into a width x height image, the board size by default.
+        // Only the tiles changed since an image was last drawn are redrawn, so keep each image
+        // between calls. Up to setDisplayImages() images can take turns, 1 by default.
+        void setDisplaySize(int width, int height);
+        void setDisplayImages(int count);
+        void colorMap(Pixel* display, int image = 0);
+        // step() followed by colorMap() in one sweep: every tile is coloured right after it is stepped,
+        // while its cells are still in cache, and the scalar engine colours each cell as it writes it
+        void stepAndColorMap(Pixel* display, int image = 0);
+        // The current generation as a cell texture, for drawing it without colorMap(). It points
+        // into the board, so upload it before the next step.
+        CellTexture cells() const;
+};
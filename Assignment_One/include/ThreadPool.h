@@ -0,0 +1,48 @@
+#pragma once
+#include <thread>
+#include <vector>
+#include <functional>
+#include <atomic>
+#include <mutex>
+#include <condition_variable>
+
+// Reusable barrier, threads spin for a short while before sleeping on a condition variable
+class SpinBarrier {
+    private:
+        const int numThreads;
+        const int spinCount;
+        std::atomic<int> waiting;
+        std::atomic<int> sleepers;
+        std::atomic<unsigned> generation;
+        std::mutex mutex;
+        std::condition_variable condition;
+
+    public:
+        SpinBarrier(int numThreads, int spinCount);
+        void arriveAndWait();
+};
+
+// Long lived pool of workers, the calling thread takes part as worker 0
+class ThreadPool {
+    private:
+        int numThreads;
+        bool pin;
+        std::vector<std::thread> workers;
+        SpinBarrier startBarrier;
+        SpinBarrier endBarrier;
+        const std::function<void(int, int)>* task;
+        bool stop;
+
+        void workerLoop(int index);
+
+    public:
+        // With pin every worker, the caller included, is bound to Topology::cpuForWorker()
+        ThreadPool(int numThreads, bool pin = false);
+        ~ThreadPool();
+        ThreadPool(const ThreadPool&) = delete;
+        ThreadPool& operator=(const ThreadPool&) = delete;
+
+        // Runs task(threadIndex, numThreads) on every worker and returns once all of them are done
+        void run(const std::function<void(int, int)>& task);
+        int size() const;
+};
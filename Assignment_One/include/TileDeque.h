@@ -0,0 +1,27 @@
+#pragma once
+#include <atomic>
+#include <cstdint>
+#include <vector>
+
+// Fixed size Chase-Lev deque of tile indices, one per worker. The owner pops from the bottom and idle
+// workers steal from the top, only the last tile is raced for. Tiles are all pushed between phases,
+// while no worker runs, so the deque never grows and needs no locks.
+class TileDeque {
+    private:
+        std::vector<int> tiles;
+        std::atomic<int64_t> top;
+        // Keeps top, written by thieves, and bottom, written by the owner, on separate cache lines
+        char padding[64];
+        std::atomic<int64_t> bottom;
+
+    public:
+        TileDeque();
+
+        // Empties the deque and fills it, only while no worker is running
+        void assign(const int* first, const int* last);
+        // Owner side, newest tile first
+        bool pop(int& tile);
+        // Any other worker, oldest tile first; false when empty or another worker won the race
+        bool steal(int& tile);
+        bool empty() const;
+};
@@ -1,49 +1,28 @@
 #include <glad/glad.h>
 #include <GLFW/glfw3.h>
+#include "../include/ThreadPool.h"
+#include "../include/Simulation.h"
+#include "Options.h"
+#include "SimdStep.h"
+#include "Rng.h"
+#include "Digest.h"
+#include "Viewport.h"
+#include "PixelStream.h"
+#include "Throughput.h"
 #include <iostream>
 #include <array>
-#include <cstdlib>  // for rand()
-#include <ctime>    // for time()
 #include <utility>
 #include <thread>
 #include <chrono>
 #include <vector>
+#include <functional>
+#include <memory>
 
 // Window Size
+// Default board size, also the largest window and display image
 const int WIDTH = 1024;
 const int HEIGHT = 768;
 
-const int deadID = -1;
-const int numSpecies = 10;
-struct Pixel { float r, g, b;};
-
-Pixel Display[HEIGHT][WIDTH];
-int8_t foregroundArray[HEIGHT][WIDTH];
-int8_t backgroundArray[HEIGHT][WIDTH];
-
-const int8_t offsets[8][2] = {
-    {-1,  0},  // up
-    { 1,  0},  // down
-    { 0, -1},  // left
-    { 0,  1},  // right
-    {-1, -1},  // up-left
-    {-1,  1},  // up-right
-    { 1, -1},  // down-left
-    { 1,  1}   // down-right
-};
-
-const Pixel colorMapping[10] = {
-    {1.0f, 0.0f, 0.0f},     // 0 = Red
-    {0.0f, 1.0f, 0.0f},     // 1 = Green
-    {0.0f, 0.0f, 1.0f},     // 2 = Blue
-    {1.0f, 1.0f, 0.0f},     // 3 = Yellow
-    {0.0f, 1.0f, 1.0f},     // 4 = Cyan
-    {1.0f, 0.0f, 1.0f},     // 5 = Magenta
-    {1.0f, 0.647f, 0.0f},   // 6 = Orange
-    {0.501f, 0.0f, 0.501f}, // 7 = Purple
-    {1.0f, 0.752f, 0.796f}, // 8 = Pink
-    {1.0f, 1.0f, 1.0f}      // 9 = White
-};
 
 // Vertex shader
 const char* vertexShaderSource = R"(
@@ -68,6 +47,27 @@ void main() {
 }
 )";
 
+// Fragment shader for --shader-palette, the texture holds the cells and the palette gives their colours.
+// Each fragment shows the cell under it, so boards larger than the window are sampled down here.
+const char* cellFragmentShaderSource = R"(
+#version 330 core
+in vec2 TexCoord;
+out vec4 FragColor;
+uniform usampler2D uTexture;
+uniform vec4 uPalette[11];
+uniform ivec2 uBoardSize;
+uniform bool uPacked;
+void main() {
+    ivec2 cell = min(ivec2(TexCoord * vec2(uBoardSize)), uBoardSize - 1);
+    uint state;
+    if (uPacked)
+        state = texelFetch(uTexture, ivec2(cell.x >> 1, cell.y), 0).r >> uint((cell.x & 1) * 4) & 15u;
+    else
+        state = (texelFetch(uTexture, cell, 0).r + 1u) & 255u;
+    FragColor = uPalette[min(state, 10u)];
+}
+)";
+
 // Shader compilation helper
 GLuint compileShader(GLenum type, const char* source) {
     GLuint shader = glCreateShader(type);
@@ -83,125 +83,87 @@ GLuint compileShader(GLenum type, const char* source) {
     return shader;
 }
 
-
-int check(int8_t foreground[][WIDTH], int8_t background[][WIDTH], int numRows, int numCols , int row, int col){
-    int cellStatus = foreground[row][col];
-    int neighborCount = 0;
-    bool isDead = false;
-    int8_t speciesCounter[numSpecies] = {0};
-
-    int testRow;
-    int testCol;
-
-    if (cellStatus == deadID) 
-        isDead = true;
-
-    for (int i = 0; i < 8; i++){
-        testRow = row + offsets[i][0];
-        testCol = col + offsets[i][1];
-
-        if (testRow >= 0 && testRow < numRows && testCol >= 0 && testCol < numCols){
-            if (cellStatus != deadID && foreground[testRow][testCol] == cellStatus)
-                neighborCount++;
-            else if (cellStatus == deadID){
-                int neighbor = foreground[testRow][testCol];
-                if (neighbor != deadID)
-                    speciesCounter[neighbor]++;
-            }
-        }
-    }
-
-    if (isDead){
-        int candidates[numSpecies];
-        int candidateCount = 0;
-        for (int s = 0; s < numSpecies; s++) {
-            if (speciesCounter[s] == 3)
-                candidates[candidateCount++] = s;
-        }
-
-        if (candidateCount > 0)
-            background[row][col] = candidates[rand() % candidateCount];
-
-        else
-            background[row][col] = deadID; // to correct buffering
-
-        return -1;
-    }
-    return neighborCount;
+// Uploads the cells into the bound texture, allocate creates it at the board size first
+void uploadCells(const CellTexture& cells, bool allocate) {
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+    glPixelStorei(GL_UNPACK_ROW_LENGTH, cells.rowLength);
+    if (allocate)
+        glTexImage2D(GL_TEXTURE_2D, 0, GL_R8UI, cells.width, cells.height, 0, GL_RED_INTEGER, GL_UNSIGNED_BYTE, cells.data);
+    else
+        glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, cells.width, cells.height, GL_RED_INTEGER, GL_UNSIGNED_BYTE, cells.data);
+    glPixelStorei(GL_UNPACK_ROW_LENGTH, 0);
 }
 
-void decide(int8_t foreground[][WIDTH], int8_t background[][WIDTH], int numRows, int numCols, int rowStart, int rowEnd){
-    int count;
-    for (int i = rowStart; i < rowEnd; i++){
-        for (int j = 0; j < numCols; j++){
-            count = check(foreground, background, numRows, numCols, i, j);
-
-            if (count != -1 && (count < 2 || count > 3) && foreground[i][j] != deadID)
-                background[i][j] = deadID;
-            else if (count != -1)
-                background[i][j] = foreground[i][j]; // to correct buffering
-                
-        }
-    }
-}
 
-void numToColorMapping(int8_t background[][WIDTH], int numCols, int rowStart, int rowEnd){
-    for (int i = rowStart; i < rowEnd; i++){
-        for (int j = 0; j < numCols; j++){
-            if (background[i][j] == -1)
-                Display[i][j] = Pixel{0.0f,0.0f,0.0f};
-            else
-                Display[i][j] = colorMapping[static_cast<int>(background[i][j])];
-        }
-    }
-}
 
-int main(){
+int main(int argc, char** argv){
+    Options options = parseOptions(argc, argv);
     using clock = std::chrono::high_resolution_clock;
-    srand(static_cast<unsigned>(time(0)));
-    // int8_t foregroundArray[HEIGHT][WIDTH];
-    // int8_t backgroundArray[HEIGHT][WIDTH];
 
-    constexpr int rows = sizeof(foregroundArray) / sizeof(foregroundArray[0]);
-    constexpr int cols = sizeof(foregroundArray[0]) / sizeof(foregroundArray[0][0]);
+    const int rows = options.height > 0 ? options.height : HEIGHT;
+    const int cols = options.width > 0 ? options.width : WIDTH;
+    const int numSpecies = options.species > 0 ? options.species : MaxSpecies;
 
-    int numThreads = 8;
-    int rowsPerThread = rows / numThreads;
-
-    // Make pointers to the arrays
-    int8_t (*foreground)[cols] = foregroundArray;
-    int8_t (*background)[cols] = backgroundArray;
+    int numThreads = options.threads > 0 ? options.threads : 8;
 
+    // Boards larger than the window are sampled down, the window then stretches the image to fit
+    int displayWidth, displayHeight, windowWidth, windowHeight;
+    fitInside(cols, rows, WIDTH, HEIGHT, false, displayWidth, displayHeight);
+    fitInside(displayWidth, displayHeight, WIDTH, HEIGHT, true, windowWidth, windowHeight);
+    std::vector<Pixel> display(static_cast<size_t>(displayWidth) * displayHeight);
 
     auto lastTime = clock::now();
     int frames = 0;
     double fps = 0.0;
-    std::vector<std::thread> threads;
 
+    std::cout << "Engine: " << engineName(options.engine) << " (" << simdLevelName(detectSimdLevel()) << ")\n";
+    std::cout << "Seed: " << options.seed << "\n";
+    std::cout << "Boundary: " << boundaryName(options.boundary) << "\n";
+    std::cout << "Schedule: " << scheduleName(options.schedule) << "\n";
+
+    // Workers are created once and reused for every phase of every frame
+    ThreadPool pool(numThreads, options.numa);
+    Simulation simulation(pool, rows, cols, numSpecies, options.engine, options.boundary, options.seed, options.tile, options.skipStable, options.numa, options.schedule);
+    simulation.setDisplaySize(displayWidth, displayHeight);
 
     // Set original values for the foregeound
-    for (int i = 0; i < HEIGHT; i++){
-        for (int j = 0; j < WIDTH; j++){
-            foregroundArray[i][j] = rand() % numSpecies;
+    for (int i = 0; i < rows; i++){
+        for (int j = 0; j < cols; j++){
+            simulation.board().at(i, j) = initialState(options.seed, i, j, numSpecies);
         }
     }
-    for (int i = 0; i < HEIGHT; i++){
-        for (int j = 0; j < WIDTH; j++)
-            backgroundArray[i][j] = foregroundArray[i][j];
+    simulation.reset();
+    if (options.numaReport)
+        simulation.printNodeReport();
+    if (options.generations > 0)
+        printDigest(0, simulation.digest());
+    // Jump ahead with HashLife, --generations then counts on from there
+    if (options.fastForward > 0){
+        simulation.fastForward(options.fastForward);
+        if (options.generations > 0)
+            printDigest(simulation.generationCount(), simulation.digest());
     }
 
-    // Do color mapping of original image
-    for (int n = 0; n < numThreads; n++){
-        int rowStart = n * rowsPerThread;
-        int rowEnd = (n == numThreads - 1) ? rows : rowStart + rowsPerThread;
-
-        threads.emplace_back(numToColorMapping, foreground, cols, rowStart, rowEnd);
+    // --headless never opens a window, each generation is stepped and colour mapped as usual
+    if (options.headless){
+        StepTimes steps;
+        for (int n = 0; n < options.generations; n++){
+            auto start = clock::now();
+            if (options.shaderPalette)
+                simulation.step();
+            else if (options.fused)
+                simulation.stepAndColorMap(display.data());
+            else{
+                simulation.step();
+                simulation.colorMap(display.data());
+            }
+            std::chrono::duration<double> elapsed = clock::now() - start;
+            steps.add(elapsed.count());
+        }
+        printDigest(simulation.generationCount(), simulation.digest());
+        printThroughput(steps, rows, cols);
+        return 0;
     }
-    // Wait for all threads to finish
-    for (auto &th : threads)
-        th.join();
-    threads.clear();
-
 
     // Initialize GLFW
     if (!glfwInit()) return -1;
@@ -209,7 +171,7 @@ int main(){
     glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
     glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
 
-    GLFWwindow* window = glfwCreateWindow(WIDTH, HEIGHT, "Game of Life", nullptr, nullptr);
+    GLFWwindow* window = glfwCreateWindow(windowWidth, windowHeight, "Game of Life", nullptr, nullptr);
     if (!window) { glfwTerminate(); return -1; }
     glfwMakeContextCurrent(window);
     glfwSwapInterval(0);
@@ -219,6 +181,22 @@ int main(){
         return -1;
     }
 
+    // --shader-palette uploads the board itself, a board too large for one texture is colour mapped here
+    bool shaderPalette = options.shaderPalette;
+    if (shaderPalette){
+        GLint maxSize = 0;
+        glGetIntegerv(GL_MAX_TEXTURE_SIZE, &maxSize);
+        CellTexture cells = simulation.cells();
+        if (cells.width > maxSize || cells.height > maxSize){
+            std::cerr << "Board does not fit a " << maxSize << " texel texture, colour mapping on the CPU\n";
+            shaderPalette = false;
+        }
+    }
+
+    // Do color mapping of original image
+    if (!shaderPalette)
+        simulation.colorMap(display.data());
+
     // Create texture
     GLuint tex;
     glGenTextures(1, &tex);
@@ -227,7 +205,10 @@ int main(){
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
-    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB, WIDTH, HEIGHT, 0, GL_RGB, GL_FLOAT, Display);
+    if (shaderPalette)
+        uploadCells(simulation.cells(), true);
+    else
+        glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, displayWidth, displayHeight, 0, GL_RGBA, GL_UNSIGNED_INT_8_8_8_8_REV, display.data());
 
     // Quad vertices
     float quadVertices[] = {
@@ -260,7 +241,7 @@ int main(){
 
     // Compile shaders
     GLuint vertexShader = compileShader(GL_VERTEX_SHADER, vertexShaderSource);
-    GLuint fragmentShader = compileShader(GL_FRAGMENT_SHADER, fragmentShaderSource);
+    GLuint fragmentShader = compileShader(GL_FRAGMENT_SHADER, shaderPalette ? cellFragmentShaderSource : fragmentShaderSource);
     GLuint shaderProgram = glCreateProgram();
     glAttachShader(shaderProgram, vertexShader);
     glAttachShader(shaderProgram, fragmentShader);
@@ -268,8 +249,22 @@ int main(){
     glDeleteShader(vertexShader);
     glDeleteShader(fragmentShader);
 
+    // With --pbo on each frame is drawn into one of the stream's two buffers in turn
+    std::unique_ptr<PixelStream> stream;
+    if (options.pixelBuffers && !shaderPalette){
+        stream.reset(new PixelStream(tex, displayWidth, displayHeight, GL_RGBA, GL_UNSIGNED_INT_8_8_8_8_REV, sizeof(Pixel)));
+        simulation.setDisplayImages(PixelStream::Slots);
+    }
+
     glUseProgram(shaderProgram);
     glUniform1i(glGetUniformLocation(shaderProgram, "uTexture"), 0); // texture unit 0
+    if (shaderPalette){
+        float palette[MaxSpecies + 1][4];
+        paletteColours(palette);
+        glUniform4fv(glGetUniformLocation(shaderProgram, "uPalette"), MaxSpecies + 1, &palette[0][0]);
+        glUniform2i(glGetUniformLocation(shaderProgram, "uBoardSize"), cols, rows);
+        glUniform1i(glGetUniformLocation(shaderProgram, "uPacked"), simulation.cells().packed);
+    }
 
 
     // Do initial drawing
@@ -282,36 +277,40 @@ int main(){
     std::this_thread::sleep_for(std::chrono::milliseconds(1000));
 
 
-    // Main loop
-    while (!glfwWindowShouldClose(window)) {
-        for (int n = 0; n < numThreads; n++){
-            int rowStart = n * rowsPerThread;
-            int rowEnd = (n == numThreads - 1) ? rows : rowStart + rowsPerThread;
-
-            threads.emplace_back(decide, foreground, background, rows, cols, rowStart, rowEnd);
-        }
-        // Wait for all threads to finish
-        for (auto &th : threads)
-            th.join();
-        threads.clear();
-
-        for (int n = 0; n < numThreads; n++){
-            int rowStart = n * rowsPerThread;
-            int rowEnd = (n == numThreads - 1) ? rows : rowStart + rowsPerThread;
-
-            threads.emplace_back(numToColorMapping, background, cols, rowStart, rowEnd);
+    // Main loop, a run with --generations stops on its own after the last one
+    const uint64_t lastGeneration = simulation.generationCount() + options.generations;
+    double uploadTime = 0.0;
+    while (!glfwWindowShouldClose(window) && (options.generations == 0 || simulation.generationCount() < lastGeneration)) {
+        int slot = static_cast<int>(simulation.generationCount() % PixelStream::Slots);
+        auto uploadStart = clock::now();
+        Pixel* image = stream ? static_cast<Pixel*>(stream->map(slot)) : display.data();
+        std::chrono::duration<double> mapping = clock::now() - uploadStart;
+        uploadTime += mapping.count();
+
+        // Fused, each tile is coloured as it is stepped, otherwise the whole image after the step
+        if (shaderPalette)
+            simulation.step();
+        else if (options.fused)
+            simulation.stepAndColorMap(image, stream ? slot : 0);
+        else{
+            simulation.step();
+            simulation.colorMap(image, stream ? slot : 0);
         }
-        // Wait for all threads to finish
-        for (auto &th : threads)
-            th.join();
-        threads.clear();
-
-        std::swap(foreground,background);
+        if (options.generations > 0)
+            printDigest(simulation.generationCount(), simulation.digest());
 
 
         // Upate texture and upload to GPU
+        uploadStart = clock::now();
         glBindTexture(GL_TEXTURE_2D, tex);
-        glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, WIDTH, HEIGHT, GL_RGB, GL_FLOAT, Display);
+        if (stream)
+            stream->upload(slot);
+        else if (shaderPalette)
+            uploadCells(simulation.cells(), false);
+        else
+            glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, displayWidth, displayHeight, GL_RGBA, GL_UNSIGNED_INT_8_8_8_8_REV, display.data());
+        std::chrono::duration<double> uploading = clock::now() - uploadStart;
+        uploadTime += uploading.count();
 
 
 
@@ -330,9 +329,10 @@ int main(){
 
         if (elapsed.count() >= 1.0) { // every 1 second
             fps = frames / elapsed.count();
-            std::cout << "FPS: " << fps << std::endl;
+            std::cout << "FPS: " << fps << ", upload " << 1000.0 * uploadTime / frames << " ms/frame" << std::endl;
 
             frames = 0;
+            uploadTime = 0.0;
             lastTime = now;
         }
 
@@ -0,0 +1,377 @@
+#include "../include/Simulation.h"
+#include "SimdStep.h"
+#include "WindowStep.h"
+#include "Rng.h"
+#include "Digest.h"
+#include "HashLife.h"
+#include "Numa.h"
+#include "Viewport.h"
+#include <algorithm>
+#include <iostream>
+#include <utility>
+
+int check(const Grid& foreground, Grid& background, const std::ptrdiff_t neighbors[8], int row, int col, int numSpecies, uint64_t seed, uint64_t generation){
+    const int8_t* cell = foreground.row(row) + col;
+    int cellStatus = *cell;
+    int neighborCount = 0;
+    // Slot 0 counts dead neighbours so the loop needs no branches
+    int8_t speciesCounter[MaxSpecies + 1] = {0};
+
+    for (int i = 0; i < 8; i++){
+        int neighbor = cell[neighbors[i]];
+        neighborCount += (neighbor == cellStatus);
+        speciesCounter[neighbor + 1]++;
+    }
+
+    if (cellStatus == deadID){
+        int candidates[MaxSpecies];
+        int candidateCount = 0;
+        for (int s = 0; s < numSpecies; s++) {
+            if (speciesCounter[s + 1] == 3)
+                candidates[candidateCount++] = s;
+        }
+
+        if (candidateCount > 0)
+            background.at(row, col) = candidates[tieBreak(seed, generation, row, col, candidateCount)];
+
+        else
+            background.at(row, col) = deadID; // to correct buffering
+
+        return -1;
+    }
+    return neighborCount;
+}
+
+void decide(const Grid& foreground, Grid& background, int rowStart, int rowEnd, int colStart, int colEnd, int numSpecies, uint64_t seed, uint64_t generation){
+    std::ptrdiff_t neighbors[8];
+    foreground.neighborOffsets(neighbors);
+
+    int count;
+    for (int i = rowStart; i < rowEnd; i++){
+        for (int j = colStart; j < colEnd; j++){
+            count = check(foreground, background, neighbors, i, j, numSpecies, seed, generation);
+
+            if (count != -1 && (count < 2 || count > 3) && foreground.at(i, j) != deadID)
+                background.at(i, j) = deadID;
+            else if (count != -1)
+                background.at(i, j) = foreground.at(i, j); // to correct buffering
+        }
+    }
+}
+
+void decideAndColor(const Grid& foreground, Grid& background, Pixel* display, int rowStart, int rowEnd, int colStart, int colEnd, int numSpecies, uint64_t seed, uint64_t generation){
+    std::ptrdiff_t neighbors[8];
+    foreground.neighborOffsets(neighbors);
+    int width = foreground.numCols();
+
+    for (int i = rowStart; i < rowEnd; i++){
+        const int8_t* cells = foreground.row(i);
+        int8_t* next = background.row(i);
+        Pixel* pixels = display + static_cast<size_t>(i) * width;
+        for (int j = colStart; j < colEnd; j++){
+            int count = check(foreground, background, neighbors, i, j, numSpecies, seed, generation);
+            // check() has already written the dead cells, count is -1 for them
+            if (count != -1)
+                next[j] = count < 2 || count > 3 ? deadID : cells[j];
+            pixels[j] = colorMapping[next[j] + 1];
+        }
+    }
+}
+
+void numToColorMapping(const Grid& background, Pixel* display, const std::vector<int>& sampleRows, const std::vector<int>& sampleCols, int rowStart, int rowEnd, int colStart, int colEnd){
+    int width = static_cast<int>(sampleCols.size());
+    for (int i = rowStart; i < rowEnd; i++){
+        const int8_t* cells = background.row(sampleRows[i]);
+        Pixel* pixels = display + static_cast<size_t>(i) * width;
+        for (int j = colStart; j < colEnd; j++)
+            pixels[j] = colorMapping[cells[sampleCols[j]] + 1];
+    }
+}
+
+void numToColorMapping(const PackedGrid& background, Pixel* display, const std::vector<int>& sampleRows, const std::vector<int>& sampleCols, int rowStart, int rowEnd, int colStart, int colEnd){
+    int width = static_cast<int>(sampleCols.size());
+    for (int i = rowStart; i < rowEnd; i++){
+        const uint64_t* words = background.row(sampleRows[i]);
+        Pixel* pixels = display + static_cast<size_t>(i) * width;
+        for (int j = colStart; j < colEnd; j++){
+            int c = sampleCols[j];
+            // Nibbles hold state + 1, so 0 is a dead cell
+            pixels[j] = colorMapping[(words[c / PackedGrid::CellsPerWord] >> ((c % PackedGrid::CellsPerWord) * 4)) & 0xF];
+        }
+    }
+}
+
+// Packed words hold 16 cells and bitplane words 64, tiles are whole words so no two tiles share one
+static int tileEdge(int tileSize, Engine engine){
+    int edge = tileSize > 0 ? tileSize : 64;
+    int word = engine == Engine::Packed ? PackedGrid::CellsPerWord : engine == Engine::Bitplane ? 64 : 1;
+    return (edge + word - 1) / word * word;
+}
+
+Simulation::Simulation(ThreadPool& pool, int rows, int cols, int numSpecies, Engine engine, Boundary boundary, uint64_t seed, int tileSize, bool skipStable, bool firstTouch, Schedule schedule) : pool(pool), engine(engine), boundary(boundary), schedule(schedule), rows(rows), cols(cols), numSpecies(numSpecies), deques(pool.size()), tiles(rows, cols, tileEdge(tileSize, engine), boundary, skipStable), activeTiles(nullptr), seed(seed), generation(0), display(nullptr), fusing(false) {
+    // The packed engine keeps a single byte board for setup and syncBoard(), the others need two
+    gridA.reset(new Grid(rows, cols, 0, !firstTouch));
+    if (engine != Engine::Packed)
+        gridB.reset(new Grid(rows, cols, 0, !firstTouch));
+    foreground = gridA.get();
+    background = gridB.get();
+    if (firstTouch){
+        pool.run([this](int n, int numThreads){
+            int rowStart = static_cast<int>(static_cast<long long>(this->rows) * n / numThreads);
+            int rowEnd = static_cast<int>(static_cast<long long>(this->rows) * (n + 1) / numThreads);
+            gridA->fillRows(rowStart, rowEnd);
+            if (gridB)
+                gridB->fillRows(rowStart, rowEnd);
+        });
+    }
+
+    planeForeground = nullptr;
+    planeBackground = nullptr;
+    if (engine == Engine::Bitplane){
+        planesA.reset(new BitplaneBoard(rows, cols, numSpecies));
+        planesB.reset(new BitplaneBoard(rows, cols, numSpecies));
+        planeForeground = planesA.get();
+        planeBackground = planesB.get();
+    }
+
+    packedForeground = nullptr;
+    packedBackground = nullptr;
+    if (engine == Engine::Packed){
+        packedA.reset(new PackedGrid(rows, cols));
+        packedB.reset(new PackedGrid(rows, cols));
+        packedForeground = packedA.get();
+        packedBackground = packedB.get();
+    }
+
+    decidePhase = [this](int n, int numThreads){
+        const std::vector<int>& active = *activeTiles;
+        if (this->schedule == Schedule::Steal){
+            // Own run first, then take from the others until every deque is empty
+            int tile;
+            while (true){
+                if (deques[n].pop(tile)){
+                    stepTile(tile);
+                    continue;
+                }
+                bool left = false;
+                for (int k = 1; k < numThreads && !left; k++){
+                    TileDeque& victim = deques[(n + k) % numThreads];
+                    if (victim.steal(tile)){
+                        stepTile(tile);
+                        left = true;
+                    }
+                    else
+                        left = !victim.empty();
+                }
+                if (!left)
+                    return;
+            }
+        }
+        // Row-major runs, which match the first-touched bands, or round-robin
+        size_t first = n, last = active.size(), stride = numThreads;
+        if (this->schedule == Schedule::Static){
+            first = active.size() * n / numThreads;
+            last = active.size() * (n + 1) / numThreads;
+            stride = 1;
+        }
+        for (size_t i = first; i < last; i += stride)
+            stepTile(active[i]);
+    };
+    colorPhase = [this](int n, int numThreads){
+        for (size_t i = n; i < drawnTiles.size(); i += numThreads)
+            colorTile(drawnTiles[i], foreground, packedForeground);
+    };
+    setDisplayImages(1);
+    setDisplaySize(cols, rows);
+}
+
+void Simulation::setDisplaySize(int width, int height){
+    sampleRows = sampleIndices(rows, height);
+    sampleCols = sampleIndices(cols, width);
+    tileRowStarts = tileStarts(sampleRows, tiles.size(), tiles.rowsOfTiles());
+    tileColStarts = tileStarts(sampleCols, tiles.size(), tiles.colsOfTiles());
+    // A new image has nothing drawn in it yet
+    tiles.markAll();
+}
+
+void Simulation::reset(){
+    if (background)
+        background->copyFrom(*foreground);
+    if (planeForeground)
+        planeForeground->load(*foreground);
+    if (packedForeground)
+        packedForeground->pack(*foreground);
+    tiles.markAll();
+    generation = 0;
+}
+
+void Simulation::syncBoard(){
+    if (packedForeground)
+        packedForeground->unpack(*foreground);
+}
+
+uint64_t Simulation::digest(){
+    syncBoard();
+    return boardDigest(*foreground);
+}
+
+void Simulation::colorTile(int tile, const Grid* board, const PackedGrid* packedBoard){
+    int tileRow = tile / tiles.colsOfTiles();
+    int tileCol = tile % tiles.colsOfTiles();
+    int rowStart = tileRowStarts[tileRow], rowEnd = tileRowStarts[tileRow + 1];
+    int colStart = tileColStarts[tileCol], colEnd = tileColStarts[tileCol + 1];
+    if (packedBoard)
+        numToColorMapping(*packedBoard, display, sampleRows, sampleCols, rowStart, rowEnd, colStart, colEnd);
+    else
+        numToColorMapping(*board, display, sampleRows, sampleCols, rowStart, rowEnd, colStart, colEnd);
+}
+
+void Simulation::stepTile(int tile){
+    int rowStart, rowEnd, colStart, colEnd;
+    tiles.bounds(tile, rowStart, rowEnd, colStart, colEnd);
+    // The scalar kernel colours as it goes when every cell has its own pixel
+    bool colored = fusing && engine == Engine::Scalar && static_cast<int>(sampleRows.size()) == rows && static_cast<int>(sampleCols.size()) == cols;
+    if (colored)
+        decideAndColor(*foreground, *background, display, rowStart, rowEnd, colStart, colEnd, numSpecies, seed, generation);
+    else{
+        switch (engine){
+            case Engine::Simd:
+                stepRowsSimd(*foreground, *background, rowStart, rowEnd, colStart, colEnd, numSpecies, seed, generation);
+                break;
+            case Engine::Window:
+                stepRowsWindow(*foreground, *background, rowStart, rowEnd, colStart, colEnd, numSpecies, seed, generation);
+                break;
+            case Engine::Bitplane:
+                // Keep the byte board in step so colour mapping works on it as usual
+                decideBitplane(*planeForeground, *planeBackground, rowStart, rowEnd, colStart, colEnd, seed, generation);
+                planeBackground->store(*background, rowStart, rowEnd, colStart, colEnd);
+                break;
+            case Engine::Packed:
+                stepRowsPacked(*packedForeground, *packedBackground, rowStart, rowEnd, colStart, colEnd, numSpecies, seed, generation);
+                break;
+            default:
+                decide(*foreground, *background, rowStart, rowEnd, colStart, colEnd, numSpecies, seed, generation);
+                break;
+        }
+    }
+    // Every tile that changed is stepped, so colouring the stepped ones keeps the image current
+    if (fusing && !colored)
+        colorTile(tile, background, packedBackground);
+    if (!tiles.tracking())
+        return;
+    if (packedForeground)
+        tiles.setChanged(tile, tileChanged(*packedForeground, *packedBackground, rowStart, rowEnd, colStart, colEnd));
+    else
+        tiles.setChanged(tile, tileChanged(*foreground, *background, rowStart, rowEnd, colStart, colEnd));
+}
+
+void Simulation::printNodeReport(){
+    syncBoard();
+    std::vector<BandReading> readings(pool.size());
+    pool.run([this, &readings](int n, int numThreads){
+        int rowStart = static_cast<int>(static_cast<long long>(rows) * n / numThreads);
+        int rowEnd = static_cast<int>(static_cast<long long>(rows) * (n + 1) / numThreads);
+        // About 64 MB per worker, so the timing is not all start-up
+        size_t bandBytes = static_cast<size_t>(rowEnd - rowStart) * foreground->rowPitch() + 1;
+        int passes = static_cast<int>(std::max<size_t>(1, (static_cast<size_t>(64) << 20) / bandBytes));
+        readings[n] = readBand(*foreground, rowStart, rowEnd, passes);
+    });
+    std::vector<const Grid*> boards;
+    boards.push_back(gridA.get());
+    if (gridB)
+        boards.push_back(gridB.get());
+    ::printNodeReport(readings, boards);
+}
+
+void Simulation::step(){
+    activeTiles = &tiles.collectActive();
+    if (schedule == Schedule::Steal){
+        // Every worker starts on its own row-major run, dealt while the pool is idle
+        const std::vector<int>& active = *activeTiles;
+        int workers = static_cast<int>(deques.size());
+        for (int n = 0; n < workers; n++)
+            deques[n].assign(active.data() + active.size() * n / workers, active.data() + active.size() * (n + 1) / workers);
+    }
+    if (packedForeground){
+        packedForeground->refreshHalo(boundary);
+        pool.run(decidePhase);
+        std::swap(packedForeground, packedBackground);
+    }
+    else{
+        foreground->refreshHalo(boundary);
+        if (planeForeground)
+            planeForeground->refreshHalo(boundary);
+        pool.run(decidePhase);
+        std::swap(foreground, background);
+        std::swap(planeForeground, planeBackground);
+    }
+    generation++;
+}
+
+void Simulation::fastForward(uint64_t target){
+    if (target <= generation)
+        return;
+    if (boundary == Boundary::Torus){
+        std::cerr << "Fast-forward only supports the dead boundary, stepping to generation " << target << "\n";
+        while (generation < target)
+            step();
+        return;
+    }
+    syncBoard();
+    HashLife hashLife(rows, cols, numSpecies, seed);
+    hashLife.load(*foreground, generation);
+    hashLife.stepTo(target);
+    hashLife.store(*foreground);
+    reset();
+    generation = target;
+}
+
+void Simulation::setDisplayImages(int count){
+    // A new image has nothing drawn in it yet
+    staleTiles.assign(count, std::vector<uint8_t>(tiles.count(), 1));
+}
+
+void Simulation::markChanged(){
+    const std::vector<int>& changed = tiles.collectChanged();
+    for (size_t i = 0; i < changed.size(); i++){
+        for (size_t image = 0; image < staleTiles.size(); image++)
+            staleTiles[image][changed[i]] = 1;
+    }
+}
+
+void Simulation::drawStale(int image){
+    std::vector<uint8_t>& stale = staleTiles[image];
+    drawnTiles.clear();
+    for (int t = 0; t < tiles.count(); t++){
+        if (stale[t]){
+            drawnTiles.push_back(t);
+            stale[t] = 0;
+        }
+    }
+    if (!drawnTiles.empty())
+        pool.run(colorPhase);
+}
+
+void Simulation::colorMap(Pixel* display, int image){
+    this->display = display;
+    markChanged();
+    drawStale(image);
+}
+
+void Simulation::stepAndColorMap(Pixel* display, int image){
+    this->display = display;
+    fusing = true;
+    step();
+    fusing = false;
+    // The stepped tiles are drawn already, which leaves the changes the image missed while another
+    // one was drawn, none with a single image
+    markChanged();
+    const std::vector<int>& stepped = *activeTiles;
+    for (size_t i = 0; i < stepped.size(); i++)
+        staleTiles[image][stepped[i]] = 0;
+    drawStale(image);
+}
+
+CellTexture Simulation::cells() const {
+    return packedForeground ? cellTexture(*packedForeground) : cellTexture(*foreground);
+}
@@ -0,0 +1,79 @@
+#include "../include/ThreadPool.h"
+#include "Numa.h"
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#include <immintrin.h>
+#define CPU_RELAX() _mm_pause()
+#else
+#define CPU_RELAX() std::this_thread::yield()
+#endif
+
+// Spinning only pays off when every thread has its own core
+static int defaultSpinCount(int numThreads){
+    unsigned cores = std::thread::hardware_concurrency();
+    return (cores != 0 && static_cast<unsigned>(numThreads) <= cores) ? 4096 : 0;
+}
+
+SpinBarrier::SpinBarrier(int numThreads, int spinCount) : numThreads(numThreads), spinCount(spinCount), waiting(0), sleepers(0), generation(0) {}
+
+void SpinBarrier::arriveAndWait(){
+    unsigned gen = generation.load();
+
+    // Last thread to arrive releases everyone else
+    if (waiting.fetch_add(1) + 1 == numThreads){
+        waiting.store(0);
+        generation.fetch_add(1);
+        if (sleepers.load() > 0){
+            { std::lock_guard<std::mutex> lock(mutex); }
+            condition.notify_all();
+        }
+        return;
+    }
+
+    for (int i = 0; i < spinCount; i++){
+        if (generation.load() != gen)
+            return;
+        CPU_RELAX();
+    }
+
+    std::unique_lock<std::mutex> lock(mutex);
+    sleepers.fetch_add(1);
+    condition.wait(lock, [&]{ return generation.load() != gen; });
+    sleepers.fetch_sub(1);
+}
+
+ThreadPool::ThreadPool(int numThreads, bool pin) : numThreads(numThreads), pin(pin), startBarrier(numThreads, defaultSpinCount(numThreads)), endBarrier(numThreads, defaultSpinCount(numThreads)), task(nullptr), stop(false) {
+    if (pin)
+        pinCurrentThread(Topology::machine().cpuForWorker(0, numThreads).id);
+    for (int i = 1; i < numThreads; i++)
+        workers.emplace_back(&ThreadPool::workerLoop, this, i);
+}
+
+ThreadPool::~ThreadPool(){
+    stop = true;
+    startBarrier.arriveAndWait();
+    for (auto &th : workers)
+        th.join();
+}
+
+void ThreadPool::workerLoop(int index){
+    if (pin)
+        pinCurrentThread(Topology::machine().cpuForWorker(index, numThreads).id);
+    while (true){
+        startBarrier.arriveAndWait();
+        if (stop)
+            return;
+        (*task)(index, numThreads);
+        endBarrier.arriveAndWait();
+    }
+}
+
+void ThreadPool::run(const std::function<void(int, int)>& task){
+    this->task = &task;
+    startBarrier.arriveAndWait();
+    task(0, numThreads);
+    endBarrier.arriveAndWait();
+}
+
+int ThreadPool::size() const {
+    return numThreads;
+}
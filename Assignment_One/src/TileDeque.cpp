@@ -0,0 +1,39 @@
+#include "../include/TileDeque.h"
+
+TileDeque::TileDeque() : top(0), bottom(0) {}
+
+void TileDeque::assign(const int* first, const int* last){
+    tiles.assign(first, last);
+    top.store(0, std::memory_order_relaxed);
+    bottom.store(static_cast<int64_t>(tiles.size()), std::memory_order_relaxed);
+}
+
+bool TileDeque::pop(int& tile){
+    int64_t b = bottom.load(std::memory_order_relaxed) - 1;
+    bottom.store(b, std::memory_order_seq_cst);
+    int64_t t = top.load(std::memory_order_seq_cst);
+    if (t > b){
+        bottom.store(b + 1, std::memory_order_relaxed);
+        return false;
+    }
+    tile = tiles[b];
+    if (t < b)
+        return true;
+    // Last tile, a thief may be taking it at the same time
+    bool won = top.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed);
+    bottom.store(b + 1, std::memory_order_relaxed);
+    return won;
+}
+
+bool TileDeque::steal(int& tile){
+    int64_t t = top.load(std::memory_order_seq_cst);
+    int64_t b = bottom.load(std::memory_order_seq_cst);
+    if (t >= b)
+        return false;
+    tile = tiles[t];
+    return top.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed);
+}
+
+bool TileDeque::empty() const {
+    return top.load(std::memory_order_seq_cst) >= bottom.load(std::memory_order_seq_cst);
+}
@@ -1,3 +1,5 @@
+#include "Rng.h"
+
 __constant int offsets[8 * 2] = {
     -1, 0,  // up
     1, 0,  // down
@@ -8,8 +10,6 @@ __constant int offsets[8 * 2] = {
     1, -1,  // down-left
     1, 1   // down-right
 };
-__constant int WIDTH = 1024;
-__constant int HEIGHT = 768;
 __constant int deadID = -1;
 __constant int MaxNumSpecies = 10;
 
@@ -17,14 +17,20 @@ __constant int MaxNumSpecies = 10;
 __kernel void CheckArray(
     __global const char* foreground,
     __global char* background,
+    const int numRows,
     const int numCols,
     const char numSpecies,
-    const int randomNumber
+    const ulong seed,
+    const ulong generation,
+    const int torus
 )
 {
     // Get the row and column this work-item will compute
     int row = get_global_id(0);
     int col = get_global_id(1);
+    // The global size is rounded up to whole work-groups
+    if (row >= numRows || col >= numCols)
+        return;
 
     int cellStatus = foreground[row * numCols + col];
     int neighborCount = 0;
@@ -33,6 +39,8 @@ __kernel void CheckArray(
 
     int testRow;
     int testCol;
+    // Only work-items on the outer ring of the board need their neighbours wrapped or dropped
+    bool interior = row > 0 && row < numRows - 1 && col > 0 && col < numCols - 1;
 
     if (cellStatus == -1)
         isDead = true;
@@ -41,16 +49,23 @@ __kernel void CheckArray(
         testRow = row + offsets[i * 2 + 0];
         testCol = col + offsets[i * 2 + 1];
 
+        if (!interior){
+            if (torus){
+                testRow = (testRow + numRows) % numRows;
+                testCol = (testCol + numCols) % numCols;
+            }
+            else if (testRow < 0 || testRow >= numRows || testCol < 0 || testCol >= numCols)
+                continue;
+        }
+
         int status = foreground[testRow * numCols + testCol];
 
-        if (testRow >= 0 && testRow < HEIGHT && testCol >= 0 && testCol < WIDTH){
-            if (cellStatus != -1 && status == cellStatus)
-                neighborCount++;
-            else if (cellStatus == -1){
-                int neighbor = status;
-                if (neighbor != -1)
-                    speciesCounter[neighbor]++;
-            }
+        if (cellStatus != -1 && status == cellStatus)
+            neighborCount++;
+        else if (cellStatus == -1){
+            int neighbor = status;
+            if (neighbor != -1)
+                speciesCounter[neighbor]++;
         }
     }
                     
@@ -63,7 +78,7 @@ __kernel void CheckArray(
                 candidates[candidateCount++] = species;
         }
         if (candidateCount > 0)
-            background[row * numCols + col] = candidates[randomNumber % candidateCount];
+            background[row * numCols + col] = candidates[tieBreak(seed, generation, row, col, candidateCount)];
         else
             background[row * numCols + col] = foreground[row * numCols + col]; // to correct buffering
     }
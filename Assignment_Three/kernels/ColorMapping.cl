@@ -18,15 +18,22 @@ __constant Pixel black = {0.0f,0.0f,0.0f};
 __kernel void ColorMapping(
     __global char* background,
     __global Pixel* display,
-    const int numCols
+    const int numRows,
+    const int numCols,
+    const int displayWidth,
+    const int displayHeight
 )
 {
-    // Get the row and column this work-item will compute
+    // Get the display pixel this work-item will compute
     int row = get_global_id(0);
     int col = get_global_id(1);
+    if (row >= displayHeight || col >= displayWidth)
+        return;
+    // Nearest cell when the board is larger than the display
+    int cell = (int)((long)row * numRows / displayHeight) * numCols + (int)((long)col * numCols / displayWidth);
 
-    if ((int)background[row * numCols + col] == -1)
-        display[row * numCols + col] = black;
+    if ((int)background[cell] == -1)
+        display[row * displayWidth + col] = black;
     else
-        display[row * numCols + col] = colorMapping[(int)background[row * numCols + col]];
+        display[row * displayWidth + col] = colorMapping[(int)background[cell]];
 }
\ No newline at end of file
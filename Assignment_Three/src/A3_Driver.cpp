@@ -4,27 +4,32 @@
 #include <CL/cl_gl.h>
 #include <glad/glad.h>
 #include <GLFW/glfw3.h>
+#include "Options.h"
+#include "Rng.h"
+#include "Digest.h"
+#include "Viewport.h"
+#include "PixelStream.h"
+#include "Throughput.h"
 #include <iostream>
-#include <cstdlib>
-#include <ctime>
 #include <utility>
 #include <chrono>
 #include <vector>
 #include <thread>
 #include <fstream>
 #include <filesystem>
+#include <memory>
 
 #ifndef KERNEL_DIR
 #define KERNEL_DIR "../kernels"
 #endif
+#ifndef COMMON_INCLUDE_DIR
+#define COMMON_INCLUDE_DIR "../../Common/include"
+#endif
 
 struct Pixel {float r, g, b;};
 const int WIDTH = 1024;
 const int HEIGHT = 768;
 const int SubMatrixSize = 64;
-Pixel display[HEIGHT * WIDTH];
-int8_t foreground[HEIGHT * WIDTH];
-int8_t background[HEIGHT * WIDTH];
 
 const Pixel colorMapping[10] = {
     {1.0f, 0.0f, 0.0f},     // 0 = Red
@@ -80,7 +85,8 @@ std::string loadFile(const std::string& path) {
     return std::string(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
 }
 
-int main(){
+int main(int argc, char** argv){
+    Options options = parseOptions(argc, argv);
     cl_device_id device;
     cl_context context;
     cl_command_queue queue;
@@ -90,30 +96,49 @@ int main(){
     cl_kernel ColorMappingKernel;
     cl_mem clForeground;
     cl_mem clBackground;
-    cl_mem clDisplay;  
-    size_t szGlobalWorkSize[2] = {HEIGHT, WIDTH}; // Global # of work items
-    size_t szLocalWorkSize[2] = {1,1}; // # of Work Items in Work Group
+    cl_mem clDisplay;
     cl_event checkArrayEvent;
     cl_platform_id selectedPlatform = nullptr;
 
     using clock = std::chrono::high_resolution_clock;
-    srand(static_cast<unsigned>(time(0)));
-    
-    int8_t numSpecies = 5 + rand() % 6;
-    // int8_t foreground[HEIGHT * WIDTH];
-    // int8_t background[HEIGHT * WIDTH];
+    cl_ulong seed = options.seed;
+    cl_ulong generation = 0;
+    std::cout << "Seed: " << seed << "\n";
+
+    int numRows = options.height > 0 ? options.height : HEIGHT;
+    int numCols = options.width > 0 ? options.width : WIDTH;
+    int8_t numSpecies = options.species > 0 ? static_cast<int8_t>(options.species) : 5 + static_cast<int8_t>(rngMix(seed) % 6);
+    int torus = options.boundary == Boundary::Torus;
+    if (options.threads > 0)
+        std::cerr << "--threads has no effect on the OpenCL backend\n";
+
+    // Boards larger than the window are sampled down, small ones are scaled up by the window
+    int displayWidth, displayHeight, windowWidth, windowHeight;
+    fitInside(numCols, numRows, WIDTH, HEIGHT, false, displayWidth, displayHeight);
+    fitInside(displayWidth, displayHeight, WIDTH, HEIGHT, true, windowWidth, windowHeight);
+    std::vector<Pixel> display(static_cast<size_t>(displayWidth) * displayHeight);
+    std::vector<int8_t> foreground(static_cast<size_t>(numRows) * numCols);
+    std::vector<int8_t> background(foreground.size());
+
+    // --tile sets the edge of a work group, the global range is rounded up to whole groups
+    // and the kernels skip the work-items that fall off the board
+    size_t tile = options.tile > 0 ? static_cast<size_t>(options.tile) : 1;
+    size_t szGlobalWorkSize[2] = {(numRows + tile - 1) / tile * tile, (numCols + tile - 1) / tile * tile}; // Global # of work items
+    size_t szColorWorkSize[2] = {(displayHeight + tile - 1) / tile * tile, (displayWidth + tile - 1) / tile * tile};
+    size_t szLocalWorkSize[2] = {tile, tile}; // # of Work Items in Work Group
 
     int frames = 0;
     double fps = 0.0;
-    int randomNum = rand();
 
     // Initialize our buffers with random values
-    for (int row = 0; row < HEIGHT; row++){
-        for (int col = 0; col < WIDTH; col++){
-            foreground[row * WIDTH + col] = rand() % numSpecies;
-            background[row * WIDTH + col] = foreground[row * WIDTH + col];
+    for (int row = 0; row < numRows; row++){
+        for (int col = 0; col < numCols; col++){
+            foreground[static_cast<size_t>(row) * numCols + col] = initialState(seed, row, col, numSpecies);
+            background[static_cast<size_t>(row) * numCols + col] = foreground[static_cast<size_t>(row) * numCols + col];
         }
     }
+    if (options.generations > 0)
+        printDigest(0, boardDigest(foreground.data(), numRows, numCols));
 
     // Display available OpenCL devices
     cl_uint numPlatforms1;
@@ -174,24 +199,24 @@ int main(){
     // Create our buffers
     clForeground = clCreateBuffer(context,
         CL_MEM_READ_WRITE | CL_MEM_COPY_HOST_PTR,
-        WIDTH * HEIGHT * sizeof(int8_t),
-        foreground,
+        foreground.size() * sizeof(int8_t),
+        foreground.data(),
         &ciErrNum);
     if(ciErrNum != CL_SUCCESS) {
         std::cerr << "Failed to create OpenCL buffer from foreground\n";
     }
     clBackground = clCreateBuffer(context,
         CL_MEM_READ_WRITE | CL_MEM_COPY_HOST_PTR,
-        WIDTH * HEIGHT * sizeof(int8_t),
-        background,
+        background.size() * sizeof(int8_t),
+        background.data(),
         &ciErrNum);
     if(ciErrNum != CL_SUCCESS) {
         std::cerr << "Failed to create OpenCL buffer from background\n";
     }
     clDisplay = clCreateBuffer(context,
         CL_MEM_READ_WRITE | CL_MEM_COPY_HOST_PTR,
-        WIDTH * HEIGHT * sizeof(Pixel),
-        display,
+        display.size() * sizeof(Pixel),
+        display.data(),
         &ciErrNum
     );
     if(ciErrNum != CL_SUCCESS) {
@@ -210,7 +235,9 @@ int main(){
     if(ciErrNum != CL_SUCCESS) {
         std::cerr << "Failed to create program\n";
     }
-    ciErrNum = clBuildProgram(program, 0, NULL, NULL, NULL, NULL);
+    // Lets CheckArray.cl include Rng.h
+    std::string buildOptions = "-I \"" + std::string(COMMON_INCLUDE_DIR) + "\"";
+    ciErrNum = clBuildProgram(program, 0, NULL, buildOptions.c_str(), NULL, NULL);
     if(ciErrNum != CL_SUCCESS) {
         std::cerr << "Failed to build program\n";
     }
@@ -239,46 +266,102 @@ int main(){
     if(ciErrNum != CL_SUCCESS) {
         std::cerr << "Failed to set kernel arg 2\n";
     }
-    ciErrNum = clSetKernelArg(CheckArrayKernel, 2, sizeof(int), &WIDTH);
+    ciErrNum = clSetKernelArg(CheckArrayKernel, 2, sizeof(int), &numRows);
     if(ciErrNum != CL_SUCCESS) {
         std::cerr << "Failed to set kernel arg 3\n";
     }
-    ciErrNum = clSetKernelArg(CheckArrayKernel, 3, sizeof(int8_t), &numSpecies);
+    ciErrNum = clSetKernelArg(CheckArrayKernel, 3, sizeof(int), &numCols);
     if(ciErrNum != CL_SUCCESS) {
         std::cerr << "Failed to set kernel arg 4\n";
     }
-    ciErrNum = clSetKernelArg(CheckArrayKernel, 4, sizeof(int), &randomNum);
+    ciErrNum = clSetKernelArg(CheckArrayKernel, 4, sizeof(int8_t), &numSpecies);
     if(ciErrNum != CL_SUCCESS) {
         std::cerr << "Failed to set kernel arg 5\n";
     }
-    ciErrNum = clSetKernelArg(ColorMappingKernel, 0, sizeof(cl_mem), &clBackground);
+    ciErrNum = clSetKernelArg(CheckArrayKernel, 5, sizeof(cl_ulong), &seed);
     if(ciErrNum != CL_SUCCESS) {
         std::cerr << "Failed to set kernel arg 6\n";
     }
-    ciErrNum = clSetKernelArg(ColorMappingKernel, 1, sizeof(cl_mem), &clDisplay);
+    ciErrNum = clSetKernelArg(CheckArrayKernel, 6, sizeof(cl_ulong), &generation);
     if(ciErrNum != CL_SUCCESS) {
         std::cerr << "Failed to set kernel arg 7\n";
     }
-    ciErrNum = clSetKernelArg(ColorMappingKernel, 2, sizeof(int), &WIDTH);
+    ciErrNum = clSetKernelArg(CheckArrayKernel, 7, sizeof(int), &torus);
     if(ciErrNum != CL_SUCCESS) {
         std::cerr << "Failed to set kernel arg 8\n";
     }
+    ciErrNum = clSetKernelArg(ColorMappingKernel, 0, sizeof(cl_mem), &clBackground);
+    if(ciErrNum != CL_SUCCESS) {
+        std::cerr << "Failed to set kernel arg 9\n";
+    }
+    ciErrNum = clSetKernelArg(ColorMappingKernel, 1, sizeof(cl_mem), &clDisplay);
+    if(ciErrNum != CL_SUCCESS) {
+        std::cerr << "Failed to set kernel arg 10\n";
+    }
+    ciErrNum = clSetKernelArg(ColorMappingKernel, 2, sizeof(int), &numRows);
+    if(ciErrNum != CL_SUCCESS) {
+        std::cerr << "Failed to set kernel arg 11\n";
+    }
+    ciErrNum = clSetKernelArg(ColorMappingKernel, 3, sizeof(int), &numCols);
+    if(ciErrNum != CL_SUCCESS) {
+        std::cerr << "Failed to set kernel arg 12\n";
+    }
+    ciErrNum = clSetKernelArg(ColorMappingKernel, 4, sizeof(int), &displayWidth);
+    if(ciErrNum != CL_SUCCESS) {
+        std::cerr << "Failed to set kernel arg 13\n";
+    }
+    ciErrNum = clSetKernelArg(ColorMappingKernel, 5, sizeof(int), &displayHeight);
+    if(ciErrNum != CL_SUCCESS) {
+        std::cerr << "Failed to set kernel arg 14\n";
+    }
 
+    // --headless never opens a window, both kernels run every generation but the image stays on the device
+    if (options.headless){
+        StepTimes steps;
+        while (generation < static_cast<cl_ulong>(options.generations)){
+            auto start = clock::now();
+            clEnqueueNDRangeKernel(queue, CheckArrayKernel, 2, NULL, szGlobalWorkSize, szLocalWorkSize, 0, NULL, &checkArrayEvent);
+            clEnqueueNDRangeKernel(queue, ColorMappingKernel, 2, NULL, szColorWorkSize, szLocalWorkSize, 1, &checkArrayEvent, NULL);
+            clReleaseEvent(checkArrayEvent);
+            std::swap(clBackground, clForeground);
+            generation++;
+            ciErrNum = clSetKernelArg(CheckArrayKernel, 6, sizeof(cl_ulong), &generation);
+            ciErrNum = clSetKernelArg(CheckArrayKernel, 0, sizeof(cl_mem), &clForeground);
+            ciErrNum = clSetKernelArg(CheckArrayKernel, 1, sizeof(cl_mem), &clBackground);
+            ciErrNum = clSetKernelArg(ColorMappingKernel, 0, sizeof(cl_mem), &clBackground);
+            // Waiting on every generation gives each its own step time
+            clFinish(queue);
+            std::chrono::duration<double> elapsed = clock::now() - start;
+            steps.add(elapsed.count());
+        }
+        ciErrNum = clEnqueueReadBuffer(queue, clForeground, CL_TRUE, 0, foreground.size() * sizeof(int8_t), foreground.data(), 0, NULL, NULL);
+        if (ciErrNum != CL_SUCCESS) {
+            std::cerr << "Failed to read board for digest\n";
+        }
+        printDigest(generation, boardDigest(foreground.data(), numRows, numCols));
+        printThroughput(steps, numRows, numCols);
+
+        clReleaseMemObject(clForeground);
+        clReleaseMemObject(clBackground);
+        clReleaseMemObject(clDisplay);
+        clReleaseKernel(CheckArrayKernel);
+        clReleaseKernel(ColorMappingKernel);
+        clReleaseProgram(program);
+        clReleaseCommandQueue(queue);
+        clReleaseContext(context);
+        return 0;
+    }
 
-
-    ciErrNum = clEnqueueNDRangeKernel(queue, ColorMappingKernel, 2, NULL, szGlobalWorkSize, szLocalWorkSize, 0, NULL, NULL);
+    // The first board is coloured and read back for the initial drawing
+    ciErrNum = clEnqueueNDRangeKernel(queue, ColorMappingKernel, 2, NULL, szColorWorkSize, szLocalWorkSize, 0, NULL, NULL);
     if(ciErrNum != CL_SUCCESS) {
         std::cerr << "Failed to Enqueue kernel\n";
     }
     clFinish(queue);
-    ciErrNum = clEnqueueReadBuffer(queue, clDisplay, CL_TRUE, 0, WIDTH * HEIGHT * sizeof(Pixel), display, 0, NULL, NULL);
+    ciErrNum = clEnqueueReadBuffer(queue, clDisplay, CL_TRUE, 0, display.size() * sizeof(Pixel), display.data(), 0, NULL, NULL);
     if(ciErrNum != CL_SUCCESS) {
         std::cerr << "Failed to read buffer\n";
     }
-    std::swap(clBackground, clForeground);
-    randomNum = rand();
-    ciErrNum = clSetKernelArg(CheckArrayKernel, 4, sizeof(int), &randomNum);
-
 
     // Initialize GLFW
     if (!glfwInit()) return -1;
@@ -286,7 +369,7 @@ int main(){
     glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
     glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
 
-    GLFWwindow* window = glfwCreateWindow(WIDTH, HEIGHT, "Game of Life", nullptr, nullptr);
+    GLFWwindow* window = glfwCreateWindow(windowWidth, windowHeight, "Game of Life", nullptr, nullptr);
     if (!window) { glfwTerminate(); return -1; }
     glfwMakeContextCurrent(window);
     glfwSwapInterval(0);
@@ -304,7 +387,7 @@ int main(){
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
-    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB, WIDTH, HEIGHT, 0, GL_RGB, GL_FLOAT, display);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB, displayWidth, displayHeight, 0, GL_RGB, GL_FLOAT, display.data());
 
     // Quad vertices
     float quadVertices[] = {
@@ -348,6 +431,12 @@ int main(){
     glUseProgram(shaderProgram);
     glUniform1i(glGetUniformLocation(shaderProgram, "uTexture"), 0);
 
+    // With --pbo on each frame is read back from the device straight into one of the stream's buffers
+    std::unique_ptr<PixelStream> stream;
+    if (options.pixelBuffers)
+        stream = std::make_unique<PixelStream>(tex, displayWidth, displayHeight, GL_RGB, GL_FLOAT, sizeof(Pixel));
+    double uploadTime = 0.0;
+
     // Do initial drawing
     glClear(GL_COLOR_BUFFER_BIT);
     glBindTexture(GL_TEXTURE_2D, tex);
@@ -359,27 +448,48 @@ int main(){
 
     std::this_thread::sleep_for(std::chrono::milliseconds(1000));
     auto lastTime = clock::now();
-    while (!glfwWindowShouldClose(window)) {
+    // A run with --generations stops on its own after the last one
+    while (!glfwWindowShouldClose(window) && (options.generations == 0 || generation < static_cast<cl_ulong>(options.generations))) {
         clEnqueueNDRangeKernel(queue, CheckArrayKernel, 2, NULL, szGlobalWorkSize, szLocalWorkSize, 0, NULL, &checkArrayEvent);
-        clEnqueueNDRangeKernel(queue, ColorMappingKernel, 2, NULL, szGlobalWorkSize, szLocalWorkSize, 1, &checkArrayEvent, NULL);
+        clEnqueueNDRangeKernel(queue, ColorMappingKernel, 2, NULL, szColorWorkSize, szLocalWorkSize, 1, &checkArrayEvent, NULL);
         clFinish(queue);
-        ciErrNum = clEnqueueReadBuffer(queue, clDisplay, CL_TRUE, 0, WIDTH * HEIGHT * sizeof(Pixel), display, 0, NULL, NULL);
+        int slot = static_cast<int>(generation % PixelStream::Slots);
+        auto uploadStart = clock::now();
+        void* image = stream ? stream->map(slot) : display.data();
+        std::chrono::duration<double> mapping = clock::now() - uploadStart;
+        uploadTime += mapping.count();
+        ciErrNum = clEnqueueReadBuffer(queue, clDisplay, CL_TRUE, 0, display.size() * sizeof(Pixel), image, 0, NULL, NULL);
             if(ciErrNum != CL_SUCCESS) {
             std::cerr << "Failed to read buffer\n";
         }
         std::swap(clBackground, clForeground);
 
+        // The newest board is in clForeground after the swap, read it back only to digest it
+        generation++;
+        if (options.generations > 0){
+            ciErrNum = clEnqueueReadBuffer(queue, clForeground, CL_TRUE, 0, foreground.size() * sizeof(int8_t), foreground.data(), 0, NULL, NULL);
+            if (ciErrNum != CL_SUCCESS) {
+                std::cerr << "Failed to read board for digest\n";
+            }
+            printDigest(generation, boardDigest(foreground.data(), numRows, numCols));
+        }
+
         // Set kernel arguments
-        randomNum = rand();
-        ciErrNum = clSetKernelArg(CheckArrayKernel, 4, sizeof(int), &randomNum);
+        ciErrNum = clSetKernelArg(CheckArrayKernel, 6, sizeof(cl_ulong), &generation);
         ciErrNum = clSetKernelArg(CheckArrayKernel, 0, sizeof(cl_mem), &clForeground);
         ciErrNum = clSetKernelArg(CheckArrayKernel, 1, sizeof(cl_mem), &clBackground);
         ciErrNum = clSetKernelArg(ColorMappingKernel, 0, sizeof(cl_mem), &clBackground);
         ciErrNum = clSetKernelArg(ColorMappingKernel, 1, sizeof(cl_mem), &clDisplay);
 
         // Upate texture and upload to GPU
+        uploadStart = clock::now();
         glBindTexture(GL_TEXTURE_2D, tex);
-        glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, WIDTH, HEIGHT, GL_RGB, GL_FLOAT, display);
+        if (stream)
+            stream->upload(slot);
+        else
+            glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, displayWidth, displayHeight, GL_RGB, GL_FLOAT, display.data());
+        std::chrono::duration<double> uploading = clock::now() - uploadStart;
+        uploadTime += uploading.count();
 
         glClear(GL_COLOR_BUFFER_BIT);
         glBindVertexArray(VAO);
@@ -393,9 +503,10 @@ int main(){
         std::chrono::duration<double> elapsed = now - lastTime;
         if (elapsed.count() >= 1.0) {
             fps = frames / elapsed.count();
-            std::cout << "FPS: " << fps << std::endl;
+            std::cout << "FPS: " << fps << ", upload " << 1000.0 * uploadTime / frames << " ms/frame" << std::endl;
 
             frames = 0;
+            uploadTime = 0.0;
             lastTime = now;
         }
         // std::this_thread::sleep_for(std::chrono::milliseconds(20));
@@ -1,34 +1,29 @@
 #pragma once
 #include <tbb/parallel_for.h>
 #include <tbb/blocked_range2d.h>
+#include "Grid.h"
+#include "PackedGrid.h"
+#include "Options.h"
 #include <iostream>
-#include <cstdlib>  // for rand()
-
-// Window Size
-const int WIDTH = 1024;
-const int HEIGHT = 768;
-const int deadID = -1;
-const int8_t offsets[8][2] = {
-    {-1,  0},  // up
-    { 1,  0},  // down
-    { 0, -1},  // left
-    { 0,  1},  // right
-    {-1, -1},  // up-left
-    {-1,  1},  // up-right
-    { 1, -1},  // down-left
-    { 1,  1}   // down-right
-};
 
+// Advances the tiles of a range, templated on the board so each kind gets its own loop with no
+// dispatch per call. Defined for Grid, by the engine picked, and for PackedGrid.
+template <typename Board>
 class CheckArray {
     private:
-        int8_t** foreground;
-        int8_t** background;
+        const Board* foreground;
+        Board* background;
         int8_t numSpecies;
+        Engine engine;
+        uint64_t seed;
+        uint64_t generation;
 
     public:
-        CheckArray();
-        CheckArray(int8_t** foreground, int8_t** background, int8_t numSpecies);
+        CheckArray() : foreground(nullptr), background(nullptr), numSpecies(-1), engine(Engine::Scalar), seed(0), generation(0) {}
+        CheckArray(const Board* foreground, Board* background, int8_t numSpecies, uint64_t seed, uint64_t generation, Engine engine = Engine::Scalar)
+            : foreground(foreground), background(background), numSpecies(numSpecies), engine(engine), seed(seed), generation(generation) {}
         void operator()(const tbb::blocked_range2d<int> &r) const;
 };
 
-
+template <> void CheckArray<Grid>::operator()(const tbb::blocked_range2d<int> &r) const;
+template <> void CheckArray<PackedGrid>::operator()(const tbb::blocked_range2d<int> &r) const;
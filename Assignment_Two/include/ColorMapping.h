@@ -1,31 +1,28 @@
 #pragma once
 #include "CheckArray.h"
+#include "Palette.h"
 #include <tbb/parallel_for.h>
 #include <tbb/blocked_range2d.h>
 #include <iostream>
+#include <vector>
 using tbb::blocked_range2d;
 
-struct Pixel { float r, g, b;};
-const Pixel colorMapping[10] = {
-    {1.0f, 0.0f, 0.0f},     // 0 = Red
-    {0.0f, 1.0f, 0.0f},     // 1 = Green
-    {0.0f, 0.0f, 1.0f},     // 2 = Blue
-    {1.0f, 1.0f, 0.0f},     // 3 = Yellow
-    {0.0f, 1.0f, 1.0f},     // 4 = Cyan
-    {1.0f, 0.0f, 1.0f},     // 5 = Magenta
-    {1.0f, 0.647f, 0.0f},   // 6 = Orange
-    {0.501f, 0.0f, 0.501f}, // 7 = Purple
-    {1.0f, 0.752f, 0.796f}, // 8 = Pink
-    {1.0f, 1.0f, 1.0f}      // 9 = White
-};
-
+// The range covers display pixels, pixel (row, col) shows cell (sampleRows[row], sampleCols[col]).
+// Templated on the board like CheckArray, defined for Grid and PackedGrid.
+template <typename Board>
 class ColorMapping {
     private:
-        int8_t** background;
-        Pixel (*display)[WIDTH]; // pointer to array of WIDTH Pixels
+        const Board* background;
+        Pixel* display;
+        const std::vector<int>* sampleRows;
+        const std::vector<int>* sampleCols;
 
     public:
-        ColorMapping();
-        ColorMapping(int8_t** background, Pixel display[][WIDTH]);
+        ColorMapping() : background(nullptr), display(nullptr), sampleRows(nullptr), sampleCols(nullptr) {}
+        ColorMapping(const Board* background, Pixel* display, const std::vector<int>* sampleRows, const std::vector<int>* sampleCols)
+            : background(background), display(display), sampleRows(sampleRows), sampleCols(sampleCols) {}
         void operator()(const blocked_range2d<int> &r) const;
-};
\ No newline at end of file
+};
+
+template <> void ColorMapping<Grid>::operator()(const blocked_range2d<int> &r) const;
+template <> void ColorMapping<PackedGrid>::operator()(const blocked_range2d<int> &r) const;
@@ -0,0 +1,35 @@
+#pragma once
+#include <tbb/parallel_for.h>
+#include <tbb/blocked_range.h>
+#include <tbb/partitioner.h>
+#include "Options.h"
+
+// Runs one pass over tiles [0, count) with the partitioner picked by --partitioner. A pass keeps
+// its own affinity_partitioner for the whole run, so as long as the tile count stays the same,
+// every tile goes back to the thread that ran it last frame and its cells are still in that
+// core's cache. The static partitioner gets the same placement from fixed equal blocks, but
+// cannot rebalance when the busy tiles move.
+class TilePartitioner {
+    private:
+        Partitioner kind;
+        tbb::affinity_partitioner affinity;
+
+    public:
+        TilePartitioner(Partitioner kind) : kind(kind) {}
+
+        template <typename Body>
+        void run(int count, const Body& body){
+            tbb::blocked_range<int> range(0, count);
+            switch (kind){
+                case Partitioner::Affinity:
+                    tbb::parallel_for(range, body, affinity);
+                    break;
+                case Partitioner::Static:
+                    tbb::parallel_for(range, body, tbb::static_partitioner());
+                    break;
+                default:
+                    tbb::parallel_for(range, body, tbb::auto_partitioner());
+                    break;
+            }
+        }
+};
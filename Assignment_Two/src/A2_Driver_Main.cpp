@@ -2,15 +2,36 @@
 #include <GLFW/glfw3.h>
 #include "../include/CheckArray.h"
 #include "../include/ColorMapping.h"
+#include "../include/TilePartitioner.h"
+#include "Options.h"
+#include "SimdStep.h"
+#include "Rng.h"
+#include "Digest.h"
+#include "Viewport.h"
+#include "DirtyTiles.h"
+#include "TemporalTiles.h"
+#include "Numa.h"
+#include "CacheCounters.h"
+#include "CellTexture.h"
+#include "PixelStream.h"
+#include "Throughput.h"
+#include <tbb/global_control.h>
+#include <tbb/enumerable_thread_specific.h>
+#include <tbb/task_scheduler_observer.h>
+#include <tbb/task_arena.h>
+#include <tbb/flow_graph.h>
 #include <iostream>
-#include <cstdlib>  // for rand()
-#include <ctime>
 #include <utility>
 #include <chrono>
 #include <vector>
 #include <thread>
+#include <memory>
+#include <algorithm>
+#include <cstring>
 
-Pixel display[HEIGHT][WIDTH];
+// Default board size, also the largest window and display image
+const int WIDTH = 1024;
+const int HEIGHT = 768;
 const int SubMatrixSize = 64;
 
 const char* vertexShaderSource = R"(
@@ -34,6 +55,27 @@ void main() {
 }
 )";
 
+// Fragment shader for --shader-palette, the texture holds the cells and the palette gives their colours.
+// Each fragment shows the cell under it, so boards larger than the window are sampled down here.
+const char* cellFragmentShaderSource = R"(
+#version 330 core
+in vec2 TexCoord;
+out vec4 FragColor;
+uniform usampler2D uTexture;
+uniform vec4 uPalette[11];
+uniform ivec2 uBoardSize;
+uniform bool uPacked;
+void main() {
+    ivec2 cell = min(ivec2(TexCoord * vec2(uBoardSize)), uBoardSize - 1);
+    uint state;
+    if (uPacked)
+        state = texelFetch(uTexture, ivec2(cell.x >> 1, cell.y), 0).r >> uint((cell.x & 1) * 4) & 15u;
+    else
+        state = (texelFetch(uTexture, cell, 0).r + 1u) & 255u;
+    FragColor = uPalette[min(state, 10u)];
+}
+)";
+
 // Shader compilation helper
 GLuint compileShader(GLenum type, const char* source) {
     GLuint shader = glCreateShader(type);
@@ -49,39 +91,345 @@ GLuint compileShader(GLenum type, const char* source) {
     return shader;
 }
 
-void CheckArrayParallel(int8_t** foreground, int8_t** background, int8_t numSpecies){
-    tbb::parallel_for(tbb::blocked_range2d<int>(0, HEIGHT, SubMatrixSize, 0, WIDTH, SubMatrixSize), CheckArray(foreground, background, numSpecies), tbb::auto_partitioner());
+// Uploads the cells into the bound texture, allocate creates it at the board size first
+void uploadCells(const CellTexture& cells, bool allocate) {
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+    glPixelStorei(GL_UNPACK_ROW_LENGTH, cells.rowLength);
+    if (allocate)
+        glTexImage2D(GL_TEXTURE_2D, 0, GL_R8UI, cells.width, cells.height, 0, GL_RED_INTEGER, GL_UNSIGNED_BYTE, cells.data);
+    else
+        glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, cells.width, cells.height, GL_RED_INTEGER, GL_UNSIGNED_BYTE, cells.data);
+    glPixelStorei(GL_UNPACK_ROW_LENGTH, 0);
+}
+
+// Display pixels drawn from the cells of each tile, tile t covers display rows from
+// tileRowStarts[t / tiles across] and columns from tileColStarts[t % tiles across]
+struct TileDisplay {
+    std::vector<int> sampleRows;
+    std::vector<int> sampleCols;
+    std::vector<int> tileRowStarts;
+    std::vector<int> tileColStarts;
+};
+
+// Draws the display pixels of one tile
+template <typename Board>
+void drawTile(const ColorMapping<Board>& body, int tile, int tileCols, const TileDisplay& view){
+    int tileRow = tile / tileCols;
+    int tileCol = tile % tileCols;
+    int rowStart = view.tileRowStarts[tileRow], rowEnd = view.tileRowStarts[tileRow + 1];
+    int colStart = view.tileColStarts[tileCol], colEnd = view.tileColStarts[tileCol + 1];
+    if (rowStart < rowEnd && colStart < colEnd)
+        body(tbb::blocked_range2d<int>(rowStart, rowEnd, colStart, colEnd));
+}
+
+// Only the tiles next to a change are recomputed, the rest keep last generation's cells. The pass
+// walks every tile so a tile keeps its place in the partitioner's range from frame to frame.
+// With a fused colour body each tile is drawn right after it is stepped, while its cells are still
+// in cache. Every tile that changed is stepped, so that keeps the image current.
+template <typename Board>
+void runActiveTiles(const Board* foreground, Board* background, DirtyTiles& tiles, const CheckArray<Board>& body, TilePartitioner& partitioner, const ColorMapping<Board>* fusedColour, const TileDisplay& view){
+    tiles.collectActive();
+    partitioner.run(tiles.count(), [&](const tbb::blocked_range<int>& r){
+        int rowStart, rowEnd, colStart, colEnd;
+        for (int t = r.begin(); t < r.end(); t++){
+            if (!tiles.isActive(t))
+                continue;
+            tiles.bounds(t, rowStart, rowEnd, colStart, colEnd);
+            body(tbb::blocked_range2d<int>(rowStart, rowEnd, colStart, colEnd));
+            if (fusedColour)
+                drawTile(*fusedColour, t, tiles.colsOfTiles(), view);
+            if (tiles.tracking())
+                tiles.setChanged(t, tileChanged(*foreground, *background, rowStart, rowEnd, colStart, colEnd));
+        }
+    });
+}
+
+// Redraws the display pixels of the tiles marked stale and clears their marks
+template <typename Board>
+void drawTiles(const Board* board, Pixel* display, std::vector<uint8_t>& stale, int tileCols, const TileDisplay& view, TilePartitioner& partitioner){
+    ColorMapping<Board> body(board, display, &view.sampleRows, &view.sampleCols);
+    partitioner.run(static_cast<int>(stale.size()), [&](const tbb::blocked_range<int>& r){
+        for (int t = r.begin(); t < r.end(); t++){
+            if (!stale[t])
+                continue;
+            stale[t] = 0;
+            drawTile(body, t, tileCols, view);
+        }
+    });
+}
+
+// fusedDisplay, when given, gets the new generation drawn into it in the same sweep
+void CheckArrayParallel(Grid* foreground, Grid* background, int8_t numSpecies, uint64_t seed, uint64_t generation, Engine engine, Boundary boundary, DirtyTiles& tiles, TilePartitioner& partitioner, Pixel* fusedDisplay, const TileDisplay& view){
+    foreground->refreshHalo(boundary);
+    ColorMapping<Grid> colour(background, fusedDisplay, &view.sampleRows, &view.sampleCols);
+    runActiveTiles(foreground, background, tiles, CheckArray<Grid>(foreground, background, numSpecies, seed, generation, engine), partitioner, fusedDisplay ? &colour : nullptr, view);
+}
+void ColorMappingParallel(const Grid* board, Pixel* display, std::vector<uint8_t>& stale, int tileCols, const TileDisplay& view, TilePartitioner& partitioner){
+    drawTiles(board, display, stale, tileCols, view, partitioner);
+}
+void CheckArrayParallel(PackedGrid* foreground, PackedGrid* background, int8_t numSpecies, uint64_t seed, uint64_t generation, Boundary boundary, DirtyTiles& tiles, TilePartitioner& partitioner, Pixel* fusedDisplay, const TileDisplay& view){
+    foreground->refreshHalo(boundary);
+    ColorMapping<PackedGrid> colour(background, fusedDisplay, &view.sampleRows, &view.sampleCols);
+    runActiveTiles(foreground, background, tiles, CheckArray<PackedGrid>(foreground, background, numSpecies, seed, generation), partitioner, fusedDisplay ? &colour : nullptr, view);
 }
-void ColorMappingParallel(int8_t** background, Pixel display[][WIDTH]){
-    tbb::parallel_for(tbb::blocked_range2d<int>(0, HEIGHT, SubMatrixSize, 0, WIDTH, SubMatrixSize), ColorMapping(background, display), tbb::auto_partitioner());
+void ColorMappingParallel(const PackedGrid* board, Pixel* display, std::vector<uint8_t>& stale, int tileCols, const TileDisplay& view, TilePartitioner& partitioner){
+    drawTiles(board, display, stale, tileCols, view, partitioner);
 }
 
-int main(){
+// Pins every thread that enters the arena by its slot, in the same order as the A1 pool
+class PinningObserver : public tbb::task_scheduler_observer {
+    private:
+        int slots;
+
+    public:
+        PinningObserver(tbb::task_arena& arena, int slots) : tbb::task_scheduler_observer(arena), slots(slots) { observe(true); }
+        ~PinningObserver() { observe(false); }
+        void on_scheduler_entry(bool) override {
+            int slot = tbb::this_task_arena::current_thread_index();
+            if (slot >= 0)
+                pinCurrentThread(Topology::machine().cpuForWorker(slot % slots, slots).id);
+        }
+};
+
+// Rows of the n-th of count bands
+void bandRows(int rows, int n, int count, int& rowStart, int& rowEnd){
+    rowStart = static_cast<int>(static_cast<long long>(rows) * n / count);
+    rowEnd = static_cast<int>(static_cast<long long>(rows) * (n + 1) / count);
+}
+
+// Advances every tile by generations generations into background, each worker in its own pair of windows
+void AdvanceTemporal(const Grid* foreground, Grid* background, const TemporalTiles& temporal, tbb::enumerable_thread_specific<TemporalTiles::Scratch>& scratch, int generations, int8_t numSpecies, uint64_t seed, uint64_t generation, TilePartitioner& partitioner){
+    partitioner.run(temporal.count(), [&](const tbb::blocked_range<int>& r){
+        TemporalTiles::Scratch& local = scratch.local();
+        for (int t = r.begin(); t < r.end(); t++)
+            temporal.advanceTile(*foreground, *background, t, generations, numSpecies, seed, generation, local);
+    });
+}
+
+// Frames the pipeline works on at once: generation N + 1 is simulated while N is colour mapped
+// and N - 1 is uploaded and presented
+const int FramesInFlight = 3;
+// Display images, one being colour mapped while the other is uploaded
+const int DisplaySlots = 2;
+static_assert(DisplaySlots == PixelStream::Slots, "each display image is one buffer of the pixel stream");
+
+// A frame on its way through the pipeline, from the start of its simulation until it is presented
+struct FrameRecord {
+    uint64_t generation = 0;
+    const Grid* board = nullptr;                // the board holding the generation
+    const PackedGrid* packedBoard = nullptr;    // the packed board holding it, with the packed engine only
+    CellTexture cells() const { return packedBoard ? cellTexture(*packedBoard) : cellTexture(*board); }
+    std::vector<int> changed;                   // tiles that differ from the frame before
+    std::chrono::high_resolution_clock::time_point started;
+};
+
+// Everything after the arena is set up, run inside it so every pass and the pipeline use its threads
+int run(const Options& options, int slots, CacheCounters& counters){
     using clock = std::chrono::high_resolution_clock;
-    srand(static_cast<unsigned>(time(0)));
+    uint64_t seed = options.seed;
     
-    int8_t numSpecies = 5 + rand() % 6;
-    int8_t** foreground = new int8_t*[HEIGHT];
-    int8_t** background = new int8_t*[HEIGHT];
+    const int rows = options.height > 0 ? options.height : HEIGHT;
+    const int cols = options.width > 0 ? options.width : WIDTH;
+    int8_t numSpecies = options.species > 0 ? static_cast<int8_t>(options.species) : 5 + static_cast<int8_t>(rngMix(seed) % 6);
+    int tile = options.tile > 0 ? options.tile : SubMatrixSize;
+
+    std::cout << "Engine: " << engineName(options.engine) << " (" << simdLevelName(detectSimdLevel()) << ")\n";
+    std::cout << "Seed: " << seed << "\n";
+    std::cout << "Boundary: " << boundaryName(options.boundary) << "\n";
+    std::cout << "Partitioner: " << partitionerName(options.partitioner) << ", arena of " << slots << " threads\n";
+
+    // Boards larger than the window are sampled down, the window then stretches the image to fit
+    int displayWidth, displayHeight, windowWidth, windowHeight;
+    fitInside(cols, rows, WIDTH, HEIGHT, false, displayWidth, displayHeight);
+    fitInside(displayWidth, displayHeight, WIDTH, HEIGHT, true, windowWidth, windowHeight);
+    std::vector<std::vector<Pixel>> displays(DisplaySlots, std::vector<Pixel>(static_cast<size_t>(displayWidth) * displayHeight));
+    // Where each display image is drawn, a mapped pixel buffer once the stream is set up
+    Pixel* images[DisplaySlots];
+    for (int slot = 0; slot < DisplaySlots; slot++)
+        images[slot] = displays[slot].data();
+
+    // Packed words hold 16 cells, whole words per tile keep two tiles from sharing one
+    if (options.engine == Engine::Packed)
+        tile = (tile + PackedGrid::CellsPerWord - 1) / PackedGrid::CellsPerWord * PackedGrid::CellsPerWord;
+    DirtyTiles tiles(rows, cols, tile, options.boundary, options.skipStable);
+    TileDisplay view;
+    view.sampleRows = sampleIndices(rows, displayHeight);
+    view.sampleCols = sampleIndices(cols, displayWidth);
+    view.tileRowStarts = tileStarts(view.sampleRows, tile, tiles.rowsOfTiles());
+    view.tileColStarts = tileStarts(view.sampleCols, tile, tiles.colsOfTiles());
+    // Each display image redraws the tiles changed since it was last colour mapped, two frames ago
+    std::vector<std::vector<uint8_t>> staleTiles(DisplaySlots, std::vector<uint8_t>(tiles.count(), 0));
+
+    // --temporal advances each tile several generations while it stays in cache, the display then
+    // only shows the last generation of every pass
+    std::unique_ptr<TemporalTiles> temporal;
+    tbb::enumerable_thread_specific<TemporalTiles::Scratch> temporalScratch;
+    if (options.temporal != 0){
+        if (options.engine != Engine::Scalar && options.engine != Engine::Simd && options.engine != Engine::Window)
+            std::cerr << "Temporal tiling needs the scalar, simd or window engine, stepping one generation per pass\n";
+        else{
+            int temporalTile = options.tile;
+            int depth = options.temporal;
+            if (depth < 0)
+                TemporalTiles::pickSizes(TemporalTiles::cacheSize(), temporalTile, depth);
+            else if (temporalTile <= 0)
+                temporalTile = std::max(SubMatrixSize, 8 * depth);
+            temporal.reset(new TemporalTiles(rows, cols, temporalTile, depth, options.boundary, options.engine));
+            std::cout << "Temporal tiling: " << depth << " generations per pass, tiles of " << temporalTile << "\n";
+        }
+    }
 
+    // The packed engine keeps a single byte board for setup and digests, the others need two
+    std::unique_ptr<Grid> foregroundGrid(new Grid(rows, cols, 0, !options.numa));
+    std::unique_ptr<Grid> backgroundGrid;
+    if (options.engine != Engine::Packed)
+        backgroundGrid.reset(new Grid(rows, cols, 0, !options.numa));
+    if (options.numa){
+        tbb::parallel_for(tbb::blocked_range<int>(0, slots), [&](const tbb::blocked_range<int>& r){
+            int rowStart, rowEnd;
+            for (int n = r.begin(); n < r.end(); n++){
+                bandRows(rows, n, slots, rowStart, rowEnd);
+                foregroundGrid->fillRows(rowStart, rowEnd);
+                if (backgroundGrid)
+                    backgroundGrid->fillRows(rowStart, rowEnd);
+            }
+        }, tbb::static_partitioner());
+    }
+    Grid* foreground = foregroundGrid.get();
+    Grid* background = backgroundGrid.get();
+
+    // The packed engine keeps its own pair of boards at 2 cells per byte
+    std::unique_ptr<PackedGrid> packedForegroundGrid, packedBackgroundGrid;
+    PackedGrid* packedForeground = nullptr;
+    PackedGrid* packedBackground = nullptr;
+    if (options.engine == Engine::Packed){
+        packedForegroundGrid.reset(new PackedGrid(rows, cols));
+        packedBackgroundGrid.reset(new PackedGrid(rows, cols));
+        packedForeground = packedForegroundGrid.get();
+        packedBackground = packedBackgroundGrid.get();
+    }
     int frames = 0;
     double fps = 0.0;
 
-    for (int i = 0; i < HEIGHT; i++){
-        foreground[i] = new int8_t[WIDTH];
-        background[i] = new int8_t[WIDTH];
+    // Initialize our foreground with random values
+    for (int row = 0; row < rows; row++){
+        for (int col = 0; col < cols; col++)
+            foreground->at(row, col) = initialState(seed, row, col, numSpecies);
+    }
+    if (background)
+        background->copyFrom(*foreground);
+
+    if (packedForeground)
+        packedForeground->pack(*foreground);
+    if (options.generations > 0)
+        printDigest(0, boardDigest(*foreground));
+    if (options.numaReport){
+        std::vector<BandReading> readings(slots);
+        tbb::parallel_for(tbb::blocked_range<int>(0, slots), [&](const tbb::blocked_range<int>& r){
+            int rowStart, rowEnd;
+            for (int n = r.begin(); n < r.end(); n++){
+                bandRows(rows, n, slots, rowStart, rowEnd);
+                // About 64 MB per band, so the timing is not all start-up
+                size_t bandBytes = static_cast<size_t>(rowEnd - rowStart) * foreground->rowPitch() + 1;
+                readings[n] = readBand(*foreground, rowStart, rowEnd, static_cast<int>(std::max<size_t>(1, (static_cast<size_t>(64) << 20) / bandBytes)));
+            }
+        }, tbb::static_partitioner());
+        std::vector<const Grid*> boards;
+        boards.push_back(foreground);
+        if (background)
+            boards.push_back(background);
+        printNodeReport(readings, boards);
     }
 
-    // Initialize our foreground with random values
-    for (int row = 0; row < HEIGHT; row++){
-        for (int col = 0; col < WIDTH; col++){
-            foreground[row][col] = rand() % numSpecies;
-            background[row][col] = foreground[row][col];
+    // Each pass keeps its partitioner, and with it where its tiles ran, for the whole run
+    TilePartitioner simulatePartitioner(options.partitioner);
+    TilePartitioner colourPartitioner(options.partitioner);
+
+    // Frame f of the run is kept in records[f % FramesInFlight] until it has been presented
+    FrameRecord records[FramesInFlight];
+    records[0].board = foreground;
+    records[0].packedBoard = packedForeground;
+    records[0].changed = tiles.collectChanged();
+    records[0].started = clock::now();
+
+    // Temporal tiling only keeps the last of its generations, so it is always coloured on its own
+    bool fusedColour = options.fused && !temporal;
+
+    // Advances the board from the generation of the frame before into this frame
+    auto simulateFrame = [&](uint64_t frame){
+        FrameRecord& record = records[frame % FramesInFlight];
+        uint64_t generation = records[(frame - 1) % FramesInFlight].generation;
+        record.started = clock::now();
+
+        // Generations this frame advances, more than one only with temporal tiling
+        int steps = temporal ? temporal->generationsPerPass() : 1;
+        if (options.generations > 0 && static_cast<uint64_t>(options.generations) - generation < static_cast<uint64_t>(steps))
+            steps = static_cast<int>(options.generations - generation);
+
+        // --fused draws the display image of this frame as the tiles are stepped
+        Pixel* fusedDisplay = fusedColour ? images[frame % DisplaySlots] : nullptr;
+        if (temporal){
+            AdvanceTemporal(foreground, background, *temporal, temporalScratch, steps, numSpecies, seed, generation, simulatePartitioner);
+            tiles.markAll();
+            std::swap(foreground, background);
         }
-    }
+        else if (packedForeground){
+            CheckArrayParallel(packedForeground, packedBackground, numSpecies, seed, generation, options.boundary, tiles, simulatePartitioner, fusedDisplay, view);
+            std::swap(packedForeground, packedBackground);
+        }
+        else{
+            CheckArrayParallel(foreground, background, numSpecies, seed, generation, options.engine, options.boundary, tiles, simulatePartitioner, fusedDisplay, view);
+            std::swap(foreground,background);
+        }
+        record.generation = generation + steps;
+        record.board = foreground;
+        record.packedBoard = packedForeground;
+        record.changed = tiles.collectChanged();
+        // A headless run is timed, it only digests the last generation
+        if (options.generations > 0 && !options.headless){
+            if (packedForeground)
+                packedForeground->unpack(*foreground);
+            printDigest(record.generation, boardDigest(*foreground));
+        }
+    };
 
-    // Perform color mapping on original data using tbb
-    ColorMappingParallel(background, display);
+    // Colour maps a frame into its display image
+    auto colourFrame = [&](uint64_t frame){
+        const FrameRecord& record = records[frame % FramesInFlight];
+        for (size_t i = 0; i < record.changed.size(); i++){
+            for (int slot = 0; slot < DisplaySlots; slot++)
+                staleTiles[slot][record.changed[i]] = 1;
+        }
+        std::vector<uint8_t>& stale = staleTiles[frame % DisplaySlots];
+        Pixel* display = images[frame % DisplaySlots];
+        if (record.packedBoard)
+            ColorMappingParallel(record.packedBoard, display, stale, tiles.colsOfTiles(), view, colourPartitioner);
+        else
+            ColorMappingParallel(record.board, display, stale, tiles.colsOfTiles(), view, colourPartitioner);
+    };
+
+    // --headless never opens a window, each frame is simulated and colour mapped in turn
+    if (options.headless){
+        uint64_t frame = 1;
+        StepTimes steps;
+        counters.start();
+        for (; records[(frame - 1) % FramesInFlight].generation < static_cast<uint64_t>(options.generations); frame++){
+            auto start = clock::now();
+            simulateFrame(frame);
+            if (!fusedColour && !options.shaderPalette)
+                colourFrame(frame);
+            std::chrono::duration<double> elapsed = clock::now() - start;
+            steps.add(elapsed.count(), static_cast<int>(records[frame % FramesInFlight].generation - records[(frame - 1) % FramesInFlight].generation));
+        }
+        counters.stop();
+        uint64_t finalGeneration = records[(frame - 1) % FramesInFlight].generation;
+        if (packedForeground)
+            packedForeground->unpack(*foreground);
+        printDigest(finalGeneration, boardDigest(*foreground));
+        printThroughput(steps, rows, cols);
+        printCacheReport(counters, static_cast<uint64_t>(rows) * cols * finalGeneration);
+        return 0;
+    }
 
     // Initialize GLFW
     if (!glfwInit()) return -1;
@@ -89,7 +437,7 @@ int main(){
     glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
     glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
 
-    GLFWwindow* window = glfwCreateWindow(WIDTH, HEIGHT, "Game of Life", nullptr, nullptr);
+    GLFWwindow* window = glfwCreateWindow(windowWidth, windowHeight, "Game of Life", nullptr, nullptr);
     if (!window) { glfwTerminate(); return -1; }
     glfwMakeContextCurrent(window);
     glfwSwapInterval(0);
@@ -99,6 +447,24 @@ int main(){
         return -1;
     }
 
+    // --shader-palette presents the boards themselves and leaves out the colour stage, a board too
+    // large for one texture is colour mapped as usual
+    bool shaderPalette = options.shaderPalette;
+    if (shaderPalette){
+        GLint maxSize = 0;
+        glGetIntegerv(GL_MAX_TEXTURE_SIZE, &maxSize);
+        CellTexture cells = records[0].cells();
+        if (cells.width > maxSize || cells.height > maxSize){
+            std::cerr << "Board does not fit a " << maxSize << " texel texture, colour mapping on the CPU\n";
+            shaderPalette = false;
+        }
+        fusedColour = fusedColour && !shaderPalette;
+    }
+
+    // Perform color mapping on original data using tbb
+    if (!shaderPalette)
+        colourFrame(0);
+
     // Create texture
     GLuint tex;
     glGenTextures(1, &tex);
@@ -107,7 +473,10 @@ int main(){
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
-    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB, WIDTH, HEIGHT, 0, GL_RGB, GL_FLOAT, display);
+    if (shaderPalette)
+        uploadCells(records[0].cells(), true);
+    else
+        glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, displayWidth, displayHeight, 0, GL_RGBA, GL_UNSIGNED_INT_8_8_8_8_REV, displays[0].data());
 
     // Quad vertices
     float quadVertices[] = {
@@ -140,7 +509,7 @@ int main(){
 
     // Compile shaders
     GLuint vertexShader = compileShader(GL_VERTEX_SHADER, vertexShaderSource);
-    GLuint fragmentShader = compileShader(GL_FRAGMENT_SHADER, fragmentShaderSource);
+    GLuint fragmentShader = compileShader(GL_FRAGMENT_SHADER, shaderPalette ? cellFragmentShaderSource : fragmentShaderSource);
     GLuint shaderProgram = glCreateProgram();
     glAttachShader(shaderProgram, vertexShader);
     glAttachShader(shaderProgram, fragmentShader);
@@ -150,6 +519,13 @@ int main(){
 
     glUseProgram(shaderProgram);
     glUniform1i(glGetUniformLocation(shaderProgram, "uTexture"), 0);
+    if (shaderPalette){
+        float palette[MaxSpecies + 1][4];
+        paletteColours(palette);
+        glUniform4fv(glGetUniformLocation(shaderProgram, "uPalette"), MaxSpecies + 1, &palette[0][0]);
+        glUniform2i(glGetUniformLocation(shaderProgram, "uBoardSize"), cols, rows);
+        glUniform1i(glGetUniformLocation(shaderProgram, "uPacked"), records[0].cells().packed);
+    }
 
     // Do initial drawing
     glClear(GL_COLOR_BUFFER_BIT);
@@ -161,17 +537,42 @@ int main(){
 
     std::this_thread::sleep_for(std::chrono::milliseconds(1000));
 
-    auto lastTime = clock::now();
-    while (!glfwWindowShouldClose(window)) {
-
-        CheckArrayParallel(foreground, background, numSpecies);
-        ColorMappingParallel(background, display);
-
-        std::swap(foreground,background);
+    // With --pbo on the display images are the two buffers of the stream, mapped on this thread before
+    // a stage draws into them. Both start out as the image of frame 0 like the displays they replace.
+    std::unique_ptr<PixelStream> stream;
+    if (options.pixelBuffers && !shaderPalette){
+        stream.reset(new PixelStream(tex, displayWidth, displayHeight, GL_RGBA, GL_UNSIGNED_INT_8_8_8_8_REV, sizeof(Pixel)));
+        for (int slot = 0; slot < DisplaySlots; slot++){
+            std::memcpy(stream->map(slot), displays[0].data(), displays[0].size() * sizeof(Pixel));
+            stream->upload(slot);
+        }
+    }
+    double uploadTime = 0.0;
+    auto mapImage = [&](uint64_t frame){
+        if (!stream)
+            return;
+        auto start = clock::now();
+        images[frame % DisplaySlots] = static_cast<Pixel*>(stream->map(frame % DisplaySlots));
+        std::chrono::duration<double> mapping = clock::now() - start;
+        uploadTime += mapping.count();
+    };
 
+    // Upload and present stay on this thread, which owns the GL context
+    double latency = 0.0;
+    int latencyFrames = 0;
+    auto presentFrame = [&](uint64_t frame){
         // Upate texture and upload to GPU
+        auto start = clock::now();
         glBindTexture(GL_TEXTURE_2D, tex);
-        glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, WIDTH, HEIGHT, GL_RGB, GL_FLOAT, display);
+        // The board of this frame is only read while the next one is simulated, so it can be uploaded as it is
+        if (stream)
+            stream->upload(frame % DisplaySlots);
+        else if (shaderPalette)
+            uploadCells(records[frame % FramesInFlight].cells(), false);
+        else
+            glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, displayWidth, displayHeight, GL_RGBA, GL_UNSIGNED_INT_8_8_8_8_REV, displays[frame % DisplaySlots].data());
+        std::chrono::duration<double> uploading = clock::now() - start;
+        uploadTime += uploading.count();
 
         glClear(GL_COLOR_BUFFER_BIT);
         glBindVertexArray(VAO);
@@ -180,20 +581,87 @@ int main(){
         glfwSwapBuffers(window);
         glfwPollEvents();
 
-
+        std::chrono::duration<double> endToEnd = clock::now() - records[frame % FramesInFlight].started;
+        latency += endToEnd.count();
+        latencyFrames++;
         frames++;
+    };
+
+    // The simulate and colour stages run on the TBB workers, each one frame at a time and in order
+    tbb::flow::graph pipeline;
+    tbb::flow::function_node<uint64_t> simulateNode(pipeline, tbb::flow::serial, [&](uint64_t frame){
+        simulateFrame(frame);
+        return tbb::flow::continue_msg();
+    });
+    tbb::flow::function_node<uint64_t> colourNode(pipeline, tbb::flow::serial, [&](uint64_t frame){
+        colourFrame(frame);
+        return tbb::flow::continue_msg();
+    });
+
+    // Frame 0 has been simulated, colour mapped and presented above
+    uint64_t simulated = 1, coloured = 1, presented = 1;
+    uint64_t lastGeneration = 0;
+    auto lastTime = clock::now();
+    counters.start();
+    while (!glfwWindowShouldClose(window)) {
+        // A run with --generations stops on its own once the last one is presented
+        bool simulating = options.generations == 0 || records[(simulated - 1) % FramesInFlight].generation < static_cast<uint64_t>(options.generations);
+        if (!simulating && presented == simulated)
+            break;
+
+        // Every stage takes the frame the stage after it finished last time, so the three frames of
+        // a round never share a board, a display image or a record. --pipeline off waits for each
+        // stage before starting the next one, which runs a single frame through at a time.
+        uint64_t simulatedBefore = simulated;
+        if (simulating){
+            if (fusedColour)
+                mapImage(simulated);
+            simulateNode.try_put(simulated++);
+        }
+        if (!options.pipeline){
+            pipeline.wait_for_all();
+            simulatedBefore = simulated;
+        }
+        uint64_t colouredBefore = coloured;
+        if (fusedColour || shaderPalette){
+            // Simulating a frame has coloured it too, or the shader colours it, so it goes straight to the present
+            coloured = simulated;
+            colouredBefore = simulatedBefore;
+        }
+        else if (coloured < simulatedBefore){
+            mapImage(coloured);
+            colourNode.try_put(coloured++);
+        }
+        if (!options.pipeline){
+            pipeline.wait_for_all();
+            colouredBefore = coloured;
+        }
+        if (presented < colouredBefore)
+            presentFrame(presented++);
+        pipeline.wait_for_all();
+
         auto now = clock::now();
         std::chrono::duration<double> elapsed = now - lastTime;
         if (elapsed.count() >= 1.0) { // every 1 second
             fps = frames / elapsed.count();
-            std::cout << "FPS: " << fps << std::endl;
+            uint64_t generation = records[(presented - 1) % FramesInFlight].generation;
+            std::cout << "FPS: " << fps << ", " << (generation - lastGeneration) / elapsed.count() << " generations/s, "
+                      << 1000.0 * latency / latencyFrames << " ms from simulation to present, upload "
+                      << 1000.0 * uploadTime / frames << " ms/frame" << std::endl;
 
             frames = 0;
+            uploadTime = 0.0;
+            latency = 0.0;
+            latencyFrames = 0;
+            lastGeneration = generation;
             lastTime = now;
         }
-        // std::this_thread::sleep_for(std::chrono::milliseconds(20));
     }
 
+    counters.stop();
+    uint64_t finalGeneration = records[(presented - 1) % FramesInFlight].generation;
+    printCacheReport(counters, static_cast<uint64_t>(rows) * cols * finalGeneration);
+
     glDeleteVertexArrays(1, &VAO);
     glDeleteBuffers(1, &VBO);
     glDeleteBuffers(1, &EBO);
@@ -201,12 +669,32 @@ int main(){
 
     glfwTerminate();
 
-    for (int i = 0; i < HEIGHT; i++){
-        delete [] foreground[i];
-        delete [] background[i];
-    }
-    delete [] foreground;
-    delete [] background;
-
     return 0;
-}
\ No newline at end of file
+}
+
+int main(int argc, char** argv){
+    Options options = parseOptions(argc, argv);
+    // CheckArray has no bitplane kernel, it would quietly run the scalar loop under the wrong name
+    if (options.engine == Engine::Bitplane){
+        std::cerr << "The bitplane engine is only in A1, using " << engineName(Engine::Scalar) << "\n";
+        options.engine = Engine::Scalar;
+    }
+    // Opened before any worker thread starts, so the counters follow all of them
+    CacheCounters counters;
+
+    // Raises the TBB worker limit when more threads are asked for than the default
+    std::unique_ptr<tbb::global_control> threadLimit;
+    if (options.threads > 0)
+        threadLimit.reset(new tbb::global_control(tbb::global_control::max_allowed_parallelism, options.threads));
+    // Every pass runs in this arena, --threads sets its concurrency
+    tbb::task_arena arena(options.threads > 0 ? options.threads : tbb::task_arena::automatic);
+    arena.initialize();
+    int slots = arena.max_concurrency();
+
+    // --numa pins the workers and has each of them first-touch one row band of the boards
+    std::unique_ptr<PinningObserver> pinning;
+    if (options.numa)
+        pinning.reset(new PinningObserver(arena, slots));
+
+    return arena.execute([&]{ return run(options, slots, counters); });
+}
@@ -1,63 +1,67 @@
 #include "../include/CheckArray.h"
+#include "SimdStep.h"
+#include "WindowStep.h"
+#include "Rng.h"
 #include <tbb/parallel_for.h>
 #include <tbb/blocked_range2d.h>
 #include <iostream>
-#include <cstdlib>
 using namespace tbb;
 
-const int MaxNumSpecies = 10;
+// A packed word belongs to the tile holding its first cell, so tiles of any width never share one
+template <>
+void CheckArray<PackedGrid>::operator()(const blocked_range2d<int> &r) const {
+    stepRowsPacked(*foreground, *background, r.rows().begin(), r.rows().end(), r.cols().begin(), r.cols().end(), numSpecies, seed, generation);
+}
 
-CheckArray::CheckArray() : foreground(nullptr), background(nullptr), numSpecies(-1) {}
-CheckArray::CheckArray(int8_t** foreground, int8_t** background, int8_t numSpecies) : foreground(foreground), background(background), numSpecies(numSpecies) {srand(static_cast<unsigned>(time(0)));}
+template <>
+void CheckArray<Grid>::operator()(const blocked_range2d<int> &r) const {
+    if (engine == Engine::Window){
+        stepRowsWindow(*foreground, *background, r.rows().begin(), r.rows().end(), r.cols().begin(), r.cols().end(), numSpecies, seed, generation);
+        return;
+    }
+    if (engine == Engine::Simd){
+        stepRowsSimd(*foreground, *background, r.rows().begin(), r.rows().end(), r.cols().begin(), r.cols().end(), numSpecies, seed, generation);
+        return;
+    }
+
+    std::ptrdiff_t neighbors[8];
+    foreground->neighborOffsets(neighbors);
 
-void CheckArray::operator()(const blocked_range2d<int> &r) const {
     for (int row = r.rows().begin(); row < r.rows().end(); row++){
+        const int8_t* cells = foreground->row(row);
+        int8_t* next = background->row(row);
         for (int col = r.cols().begin(); col < r.cols().end(); col++){
-            int cellStatus = *(*(foreground + row) + col);
+            const int8_t* cell = cells + col;
+            int cellStatus = *cell;
             int neighborCount = 0;
-            bool isDead = false;
-            int speciesCounter[MaxNumSpecies] = {0};
-
-            int testRow;
-            int testCol;
-
-            if (cellStatus == deadID)
-                isDead = true;
+            // Slot 0 counts dead neighbours, the ghost border makes every neighbour readable
+            int speciesCounter[MaxSpecies + 1] = {0};
 
             for (int i = 0; i < 8; i++){
-                testRow = row + offsets[i][0];
-                testCol = col + offsets[i][1];
-
-                if (testRow >= 0 && testRow < HEIGHT && testCol >= 0 && testCol < WIDTH){
-                    if (cellStatus != deadID && foreground[testRow][testCol] == cellStatus)
-                        neighborCount++;
-                    else if (cellStatus == deadID){
-                        int neighbor = foreground[testRow][testCol];
-                        if (neighbor != deadID)
-                            speciesCounter[neighbor]++;
-                    }
-                }
+                int neighbor = cell[neighbors[i]];
+                neighborCount += (neighbor == cellStatus);
+                speciesCounter[neighbor + 1]++;
             }
                     
-            if (isDead){
-                int candidates[MaxNumSpecies] = {0};
+            if (cellStatus == deadID){
+                int candidates[MaxSpecies] = {0};
                 int candidateCount = 0;
 
                 for (int species = 0; species < numSpecies; species++){
-                    if (speciesCounter[species] == 3)
+                    if (speciesCounter[species + 1] == 3)
                         candidates[candidateCount++] = species;
                 }
                 if (candidateCount > 0)
-                    background[row][col] = candidates[rand() % candidateCount];
+                    next[col] = candidates[tieBreak(seed, generation, row, col, candidateCount)];
                 else
-                    background[row][col] = foreground[row][col]; // to correct buffering
+                    next[col] = cellStatus; // to correct buffering
             }
             else{
-                if ((neighborCount < 2 || neighborCount > 3) && *(*(foreground + row) + col) != deadID)
-                    background[row][col] = deadID;
+                if (neighborCount < 2 || neighborCount > 3)
+                    next[col] = deadID;
                 else
-                    background[row][col] = foreground[row][col]; // to correct buffering
+                    next[col] = cellStatus; // to correct buffering
             }
         }
     }
-}
\ No newline at end of file
+}
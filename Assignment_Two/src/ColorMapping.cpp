@@ -5,16 +5,35 @@
 #include <iostream>
 using tbb::blocked_range2d;
 
-ColorMapping::ColorMapping() : background(nullptr), display(nullptr) {}
-ColorMapping::ColorMapping(int8_t** background, Pixel display[][WIDTH]) : background(background), display(display) {}
-        
-void ColorMapping::operator()(const blocked_range2d<int> &r) const {
+template <>
+void ColorMapping<PackedGrid>::operator()(const blocked_range2d<int> &r) const {
+    size_t width = sampleCols->size();
     for (int row = r.rows().begin(); row < r.rows().end(); row++){
+        const uint64_t* words = background->row((*sampleRows)[row]);
+        Pixel* pixels = display + row * width;
         for (int col = r.cols().begin(); col < r.cols().end(); col++){
-            if (background[row][col] == deadID)
-                display[row][col] = Pixel{0.0f, 0.0f, 0.0f};
-            else
-                display[row][col] = colorMapping[static_cast<int>(background[row][col])];
+            int c = (*sampleCols)[col];
+            // Nibbles hold state + 1, so 0 is a dead cell
+            pixels[col] = colorMapping[(words[c / PackedGrid::CellsPerWord] >> ((c % PackedGrid::CellsPerWord) * 4)) & 0xF];
         }
     }
-}
\ No newline at end of file
+}
+
+template <>
+void ColorMapping<Grid>::operator()(const blocked_range2d<int> &r) const {
+    size_t width = sampleCols->size();
+    // Increasing distinct columns as many as the board has can only be every column in order,
+    // the inner loop then reads the row straight through and vectorises
+    bool sampled = static_cast<int>(width) != background->numCols();
+    for (int row = r.rows().begin(); row < r.rows().end(); row++){
+        const int8_t* cells = background->row((*sampleRows)[row]);
+        Pixel* pixels = display + row * width;
+        if (!sampled){
+            for (int col = r.cols().begin(); col < r.cols().end(); col++)
+                pixels[col] = colorMapping[cells[col] + 1];
+            continue;
+        }
+        for (int col = r.cols().begin(); col < r.cols().end(); col++)
+            pixels[col] = colorMapping[cells[(*sampleCols)[col]] + 1];
+    }
+}
@@ -0,0 +1,370 @@
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#if defined(_WIN32)
+#define popen _popen
+#define pclose _pclose
+#endif
+
+// The four engines, each one the app of its assignment run with --headless
+struct Backend {
+    const char* name;
+    const char* folder;
+    bool usesThreads;   // the OpenCL apps ignore --threads, so they run once per board
+    bool usesPartitioner;   // only A2 hands its tiles out through a TBB partitioner
+};
+
+const Backend backends[] = {
+    {"thread", "Assignment_One", true, false},
+    {"tbb", "Assignment_Two", true, true},
+    {"opencl-copy", "Assignment_Three", false, false},
+    {"opencl-interop", "Assignment_Four", false, false},
+};
+const int BackendCount = sizeof(backends) / sizeof(backends[0]);
+
+// Values A2 takes for --partitioner
+const char* const partitioners[] = {"auto", "affinity", "static"};
+
+struct Size {
+    int width;
+    int height;
+};
+
+struct BenchOptions {
+    std::vector<Size> sizes = {{512, 512}, {1024, 1024}, {2048, 2048}};
+    std::vector<int> species = {2, 5, 10};
+    std::vector<int> threads;       // 1 and every core unless --threads is given
+    std::vector<std::string> backends = {"thread", "tbb", "opencl-copy", "opencl-interop"};
+    std::string apps[BackendCount]; // app of each backend, the build folder of its assignment unless given
+    int generations = 200;
+    unsigned long long seed = 1;
+    std::string engine;             // passed on as --engine to the CPU apps when given
+    std::vector<std::string> partitioners;  // each run of the tbb backend once per entry, A2's default when empty
+    std::string format = "json";
+    std::string out;                // standard output when empty
+};
+
+// One run of one app, parsed from the digest, "Headless:" and "L2:" lines it ends with
+struct Result {
+    std::string backend;
+    Size size;
+    int species;
+    int threads;                    // 0 for the OpenCL apps
+    std::string partitioner;        // empty when the app's default was used
+    unsigned long long generations;
+    double seconds;
+    double generationsPerSecond;
+    double cellsPerSecond;
+    double meanMs;
+    double p50Ms;
+    double p99Ms;
+    std::string digest;
+    bool agrees;                    // same final board as the first backend run on this workload
+    bool hasL2;                     // the app printed hardware cache counters, only A2 does
+    unsigned long long l2Misses;
+    unsigned long long l2Accesses;
+};
+
+static std::vector<std::string> split(const std::string& text, char separator){
+    std::vector<std::string> parts;
+    std::stringstream stream(text);
+    std::string part;
+    while (std::getline(stream, part, separator)){
+        if (!part.empty())
+            parts.push_back(part);
+    }
+    return parts;
+}
+
+static bool parseInts(const std::string& text, std::vector<int>& values){
+    std::vector<int> parsed;
+    for (const std::string& part : split(text, ',')){
+        char* end = nullptr;
+        long value = std::strtol(part.c_str(), &end, 10);
+        if (*end != '\0' || value <= 0)
+            return false;
+        parsed.push_back(static_cast<int>(value));
+    }
+    if (parsed.empty())
+        return false;
+    values = parsed;
+    return true;
+}
+
+static bool parseSizes(const std::string& text, std::vector<Size>& sizes){
+    std::vector<Size> parsed;
+    for (const std::string& part : split(text, ',')){
+        Size size;
+        char x = 0;
+        std::istringstream stream(part);
+        if (!(stream >> size.width >> x >> size.height) || x != 'x' || !stream.eof() || size.width <= 0 || size.height <= 0)
+            return false;
+        parsed.push_back(size);
+    }
+    if (parsed.empty())
+        return false;
+    sizes = parsed;
+    return true;
+}
+
+static int backendIndex(const std::string& name){
+    for (int i = 0; i < BackendCount; i++){
+        if (name == backends[i].name)
+            return i;
+    }
+    return -1;
+}
+
+// Where CMake builds an assignment, next to its sources as the README describes
+static std::string defaultApp(const Backend& backend){
+    std::string folder = std::string(GOL_SOURCE_DIR) + "/" + backend.folder + "/build/";
+#if defined(_WIN32)
+    return folder + "Debug/app.exe";
+#else
+    return folder + "app";
+#endif
+}
+
+static BenchOptions parseBenchOptions(int argc, char** argv){
+    BenchOptions options;
+    unsigned cores = std::thread::hardware_concurrency();
+    options.threads.push_back(1);
+    if (cores > 1)
+        options.threads.push_back(static_cast<int>(cores));
+
+    for (int i = 1; i < argc; i++){
+        std::string flag = argv[i];
+        bool hasValue = i + 1 < argc;
+        if (!hasValue){
+            std::cerr << "Ignoring " << flag << " without a value\n";
+            break;
+        }
+        std::string value = argv[++i];
+        if (flag == "--sizes"){
+            if (!parseSizes(value, options.sizes))
+                std::cerr << "Invalid sizes " << value << ", expected e.g. 512x512,1024x768\n";
+        }
+        else if (flag == "--species"){
+            if (!parseInts(value, options.species))
+                std::cerr << "Invalid species " << value << ", expected e.g. 2,5,10\n";
+        }
+        else if (flag == "--threads"){
+            if (!parseInts(value, options.threads))
+                std::cerr << "Invalid threads " << value << ", expected e.g. 1,2,4\n";
+        }
+        else if (flag == "--generations"){
+            std::vector<int> generations;
+            if (parseInts(value, generations) && generations.size() == 1)
+                options.generations = generations[0];
+            else
+                std::cerr << "Invalid generations " << value << "\n";
+        }
+        else if (flag == "--seed")
+            options.seed = std::strtoull(value.c_str(), nullptr, 10);
+        else if (flag == "--backends"){
+            std::vector<std::string> names = split(value, ',');
+            bool known = !names.empty();
+            for (const std::string& name : names){
+                if (backendIndex(name) < 0){
+                    std::cerr << "Unknown backend " << name << "\n";
+                    known = false;
+                }
+            }
+            if (known)
+                options.backends = names;
+        }
+        else if (flag == "--engine")
+            options.engine = value;
+        else if (flag == "--partitioners"){
+            std::vector<std::string> names = split(value, ',');
+            bool known = !names.empty();
+            for (const std::string& name : names){
+                bool found = false;
+                for (const char* partitioner : partitioners)
+                    found = found || name == partitioner;
+                if (!found){
+                    std::cerr << "Unknown partitioner " << name << ", expected auto, affinity or static\n";
+                    known = false;
+                }
+            }
+            if (known)
+                options.partitioners = names;
+        }
+        else if (flag == "--format"){
+            if (value == "json" || value == "csv")
+                options.format = value;
+            else
+                std::cerr << "Unknown format " << value << ", using " << options.format << "\n";
+        }
+        else if (flag == "--out")
+            options.out = value;
+        else if (flag.compare(0, 2, "--") == 0 && backendIndex(flag.substr(2)) >= 0)
+            options.apps[backendIndex(flag.substr(2))] = value;
+        else
+            std::cerr << "Ignoring unknown option " << flag << "\n";
+    }
+
+    for (int i = 0; i < BackendCount; i++){
+        if (options.apps[i].empty())
+            options.apps[i] = defaultApp(backends[i]);
+    }
+    return options;
+}
+
+// Runs one app to the end and reads its last digest, the throughput line and the L2 line if any, false if it failed
+static bool runApp(const std::string& command, Result& result){
+    FILE* pipe = popen(command.c_str(), "r");
+    if (!pipe)
+        return false;
+    bool headless = false;
+    char line[512];
+    while (std::fgets(line, sizeof(line), pipe)){
+        unsigned long long generation = 0;
+        char digest[17] = {0};
+        if (std::sscanf(line, "generation %llu digest %16s", &generation, digest) == 2)
+            result.digest = digest;
+        else if (std::sscanf(line, "Headless: %llu generations in %lf s, %lf generations/s, %lf cells/s, step mean %lf ms p50 %lf ms p99 %lf ms",
+                             &result.generations, &result.seconds, &result.generationsPerSecond, &result.cellsPerSecond,
+                             &result.meanMs, &result.p50Ms, &result.p99Ms) == 7)
+            headless = true;
+        else if (std::sscanf(line, "L2: %llu misses of %llu accesses", &result.l2Misses, &result.l2Accesses) == 2)
+            result.hasL2 = true;
+    }
+    int status = pclose(pipe);
+    return status == 0 && headless && !result.digest.empty();
+}
+
+static void writeJson(std::ostream& out, const BenchOptions& options, const std::vector<Result>& results){
+    out << "{\n  \"seed\": " << options.seed << ",\n  \"generations\": " << options.generations << ",\n  \"results\": [";
+    for (size_t i = 0; i < results.size(); i++){
+        const Result& r = results[i];
+        out << (i > 0 ? "," : "") << "\n    {\"backend\": \"" << r.backend << "\", \"width\": " << r.size.width << ", \"height\": " << r.size.height
+            << ", \"species\": " << r.species << ", \"threads\": ";
+        if (r.threads > 0)
+            out << r.threads;
+        else
+            out << "null";
+        out << ", \"partitioner\": ";
+        if (!r.partitioner.empty())
+            out << "\"" << r.partitioner << "\"";
+        else
+            out << "null";
+        out << ", \"generations\": " << r.generations << ", \"seconds\": " << r.seconds
+            << ", \"generations_per_second\": " << r.generationsPerSecond << ", \"cells_per_second\": " << r.cellsPerSecond
+            << ", \"step_mean_ms\": " << r.meanMs << ", \"step_p50_ms\": " << r.p50Ms << ", \"step_p99_ms\": " << r.p99Ms
+            << ", \"digest\": \"" << r.digest << "\", \"agrees\": " << (r.agrees ? "true" : "false");
+        if (r.hasL2){
+            out << ", \"l2_misses\": " << r.l2Misses << ", \"l2_accesses\": " << r.l2Accesses << ", \"l2_miss_rate\": ";
+            if (r.l2Accesses > 0)
+                out << static_cast<double>(r.l2Misses) / r.l2Accesses;
+            else
+                out << "null";
+        }
+        else
+            out << ", \"l2_misses\": null, \"l2_accesses\": null, \"l2_miss_rate\": null";
+        out << "}";
+    }
+    out << "\n  ]\n}\n";
+}
+
+static void writeCsv(std::ostream& out, const std::vector<Result>& results){
+    out << "backend,width,height,species,threads,partitioner,generations,seconds,generations_per_second,cells_per_second,step_mean_ms,step_p50_ms,step_p99_ms,digest,agrees,l2_misses,l2_accesses,l2_miss_rate\n";
+    for (const Result& r : results){
+        out << r.backend << "," << r.size.width << "," << r.size.height << "," << r.species << ",";
+        if (r.threads > 0)
+            out << r.threads;
+        out << "," << r.partitioner << "," << r.generations << "," << r.seconds << "," << r.generationsPerSecond << "," << r.cellsPerSecond
+            << "," << r.meanMs << "," << r.p50Ms << "," << r.p99Ms << "," << r.digest << "," << (r.agrees ? "true" : "false") << ",";
+        // Left empty when the app had no hardware cache counters
+        if (r.hasL2){
+            out << r.l2Misses << "," << r.l2Accesses << ",";
+            if (r.l2Accesses > 0)
+                out << static_cast<double>(r.l2Misses) / r.l2Accesses;
+        }
+        else
+            out << ",,";
+        out << "\n";
+    }
+}
+
+int main(int argc, char** argv){
+    BenchOptions options = parseBenchOptions(argc, argv);
+    std::vector<Result> results;
+    bool failed = false;
+
+    // Every backend sees the same seed, board and species, so their final digests should agree
+    for (const Size& size : options.sizes){
+        for (int species : options.species){
+            std::string workload = " --headless --seed " + std::to_string(options.seed) + " --generations " + std::to_string(options.generations)
+                                 + " --width " + std::to_string(size.width) + " --height " + std::to_string(size.height)
+                                 + " --species " + std::to_string(species);
+            std::string reference;
+            for (const std::string& name : options.backends){
+                int index = backendIndex(name);
+                const Backend& backend = backends[index];
+                std::vector<int> threadCounts = backend.usesThreads ? options.threads : std::vector<int>(1, 0);
+                std::vector<std::string> partitionerNames = backend.usesPartitioner && !options.partitioners.empty() ? options.partitioners : std::vector<std::string>(1, "");
+                for (int threads : threadCounts){
+                    for (const std::string& partitioner : partitionerNames){
+                        std::string command = "\"" + options.apps[index] + "\"" + workload;
+                        if (threads > 0)
+                            command += " --threads " + std::to_string(threads);
+                        if (backend.usesThreads && !options.engine.empty())
+                            command += " --engine " + options.engine;
+                        if (!partitioner.empty())
+                            command += " --partitioner " + partitioner;
+#if defined(_WIN32)
+                        // cmd strips the outer pair, which keeps the quoted path intact
+                        command = "\"" + command + "\"";
+#endif
+                        std::cerr << name << " " << size.width << "x" << size.height << " species " << species;
+                        if (threads > 0)
+                            std::cerr << " threads " << threads;
+                        if (!partitioner.empty())
+                            std::cerr << " partitioner " << partitioner;
+                        std::cerr << "\n";
+
+                        Result result = Result();
+                        result.backend = name;
+                        result.size = size;
+                        result.species = species;
+                        result.threads = threads;
+                        result.partitioner = partitioner;
+                        if (!runApp(command, result)){
+                            std::cerr << "Failed to run " << options.apps[index] << ", skipping\n";
+                            failed = true;
+                            continue;
+                        }
+                        if (reference.empty())
+                            reference = result.digest;
+                        result.agrees = result.digest == reference;
+                        if (!result.agrees)
+                            std::cerr << name << " ended on digest " << result.digest << " instead of " << reference << "\n";
+                        results.push_back(result);
+                    }
+                }
+            }
+        }
+    }
+
+    std::ofstream file;
+    if (!options.out.empty()){
+        file.open(options.out);
+        if (!file){
+            std::cerr << "Failed to open " << options.out << "\n";
+            return 1;
+        }
+    }
+    std::ostream& out = options.out.empty() ? std::cout : file;
+    if (options.format == "csv")
+        writeCsv(out, results);
+    else
+        writeJson(out, options, results);
+    return failed ? 1 : 0;
+}
@@ -0,0 +1,179 @@
+#include <benchmark/benchmark.h>
+#include <tbb/blocked_range2d.h>
+#include "Simulation.h"
+#include "CheckArray.h"
+#include "ColorMapping.h"
+#include "Grid.h"
+#include "PackedGrid.h"
+#include "Palette.h"
+#include "Rng.h"
+#include "Viewport.h"
+#include <cstdint>
+#include <vector>
+
+// One tile of the default size, small enough to stay in L1 so only the inner loops are timed
+const int TileSize = 64;
+const int TileCells = TileSize * TileSize;
+const uint64_t Seed = 426;
+
+// Bytes each kernel moves per cell: the cell read and written for a step, the cell read and the
+// pixel written for a colour map, packed boards hold a cell in half a byte. Neighbours are reread
+// from cache and not counted.
+const double GridStepBytes = 2.0;
+const double PackedStepBytes = 1.0;
+const double GridColourBytes = 1.0 + sizeof(Pixel);
+const double PackedColourBytes = 0.5 + sizeof(Pixel);
+
+// A tile with about density percent of its cells alive, each of one of species species
+static void fillTile(Grid& grid, int density, int species){
+    for (int r = 0; r < TileSize; r++){
+        for (int c = 0; c < TileSize; c++){
+            bool alive = cellRandom(Seed, 0, r, c) % 100 < static_cast<uint64_t>(density);
+            grid.at(r, c) = alive ? initialState(Seed, r, c, species) : deadID;
+        }
+    }
+    grid.refreshHalo(Boundary::Dead);
+}
+
+// Adds time/cell (e.g. 13.7ns) and bytes/cell to the usual timings
+static void reportPerCell(benchmark::State& state, double bytesPerCell){
+    int64_t cells = static_cast<int64_t>(state.iterations()) * TileCells;
+    state.SetItemsProcessed(cells);
+    state.SetBytesProcessed(static_cast<int64_t>(cells * bytesPerCell));
+    state.counters["time/cell"] = benchmark::Counter(static_cast<double>(cells), benchmark::Counter::kIsRate | benchmark::Counter::kInvert);
+    state.counters["bytes/cell"] = bytesPerCell;
+}
+
+// Every combination of live-cell density (percent) and species count
+static void densityAndSpecies(benchmark::internal::Benchmark* benchmark){
+    for (int density : {10, 35, 60, 90}){
+        for (int species : {1, 2, 5, MaxSpecies})
+            benchmark->Args({density, species});
+    }
+    benchmark->ArgNames({"density", "species"});
+}
+
+// A1: check() cell by cell, the loop decide() runs without its survival rule
+static void BM_Check(benchmark::State& state){
+    int species = static_cast<int>(state.range(1));
+    Grid foreground(TileSize, TileSize), background(TileSize, TileSize);
+    fillTile(foreground, static_cast<int>(state.range(0)), species);
+    std::ptrdiff_t neighbors[8];
+    foreground.neighborOffsets(neighbors);
+    for (auto _ : state){
+        for (int r = 0; r < TileSize; r++){
+            for (int c = 0; c < TileSize; c++)
+                benchmark::DoNotOptimize(check(foreground, background, neighbors, r, c, species, Seed, 1));
+        }
+        benchmark::ClobberMemory();
+    }
+    reportPerCell(state, GridStepBytes);
+}
+BENCHMARK(BM_Check)->Apply(densityAndSpecies);
+
+// A1: decide() over the whole tile
+static void BM_Decide(benchmark::State& state){
+    int species = static_cast<int>(state.range(1));
+    Grid foreground(TileSize, TileSize), background(TileSize, TileSize);
+    fillTile(foreground, static_cast<int>(state.range(0)), species);
+    for (auto _ : state){
+        decide(foreground, background, 0, TileSize, 0, TileSize, species, Seed, 1);
+        benchmark::ClobberMemory();
+    }
+    reportPerCell(state, GridStepBytes);
+}
+BENCHMARK(BM_Decide)->Apply(densityAndSpecies);
+
+// A1: numToColorMapping() of the tile into an image of the same size
+static void BM_NumToColorMapping(benchmark::State& state){
+    Grid board(TileSize, TileSize);
+    fillTile(board, static_cast<int>(state.range(0)), static_cast<int>(state.range(1)));
+    std::vector<int> samples = sampleIndices(TileSize, TileSize);
+    std::vector<Pixel> display(TileCells);
+    for (auto _ : state){
+        numToColorMapping(board, display.data(), samples, samples, 0, TileSize, 0, TileSize);
+        benchmark::ClobberMemory();
+    }
+    reportPerCell(state, GridColourBytes);
+}
+BENCHMARK(BM_NumToColorMapping)->Apply(densityAndSpecies);
+
+// A2: CheckArray::operator() on the tile as one range, run directly so no TBB scheduling is timed.
+// The third argument is the engine, scalar or simd.
+static void BM_CheckArray(benchmark::State& state){
+    int species = static_cast<int>(state.range(1));
+    Engine engine = state.range(2) ? Engine::Simd : Engine::Scalar;
+    Grid foreground(TileSize, TileSize), background(TileSize, TileSize);
+    fillTile(foreground, static_cast<int>(state.range(0)), species);
+    CheckArray<Grid> step(&foreground, &background, static_cast<int8_t>(species), Seed, 1, engine);
+    tbb::blocked_range2d<int> tile(0, TileSize, 0, TileSize);
+    for (auto _ : state){
+        step(tile);
+        benchmark::ClobberMemory();
+    }
+    state.SetLabel(engineName(engine));
+    reportPerCell(state, GridStepBytes);
+}
+BENCHMARK(BM_CheckArray)->Apply([](benchmark::internal::Benchmark* benchmark){
+    for (int density : {10, 35, 60, 90}){
+        for (int species : {1, 2, 5, MaxSpecies}){
+            for (int simd : {0, 1})
+                benchmark->Args({density, species, simd});
+        }
+    }
+    benchmark->ArgNames({"density", "species", "simd"});
+});
+
+// A2: CheckArray::operator() on the packed board
+static void BM_CheckArrayPacked(benchmark::State& state){
+    int species = static_cast<int>(state.range(1));
+    Grid tile(TileSize, TileSize);
+    fillTile(tile, static_cast<int>(state.range(0)), species);
+    PackedGrid foreground(TileSize, TileSize), background(TileSize, TileSize);
+    foreground.pack(tile);
+    foreground.refreshHalo(Boundary::Dead);
+    CheckArray<PackedGrid> step(&foreground, &background, static_cast<int8_t>(species), Seed, 1);
+    tbb::blocked_range2d<int> range(0, TileSize, 0, TileSize);
+    for (auto _ : state){
+        step(range);
+        benchmark::ClobberMemory();
+    }
+    reportPerCell(state, PackedStepBytes);
+}
+BENCHMARK(BM_CheckArrayPacked)->Apply(densityAndSpecies);
+
+// A2: ColorMapping::operator() of the tile into an image of the same size
+static void BM_ColorMapping(benchmark::State& state){
+    Grid board(TileSize, TileSize);
+    fillTile(board, static_cast<int>(state.range(0)), static_cast<int>(state.range(1)));
+    std::vector<int> samples = sampleIndices(TileSize, TileSize);
+    std::vector<Pixel> display(TileCells);
+    ColorMapping<Grid> colour(&board, display.data(), &samples, &samples);
+    tbb::blocked_range2d<int> tile(0, TileSize, 0, TileSize);
+    for (auto _ : state){
+        colour(tile);
+        benchmark::ClobberMemory();
+    }
+    reportPerCell(state, GridColourBytes);
+}
+BENCHMARK(BM_ColorMapping)->Apply(densityAndSpecies);
+
+// A2: ColorMapping::operator() of the packed board
+static void BM_ColorMappingPacked(benchmark::State& state){
+    Grid tile(TileSize, TileSize);
+    fillTile(tile, static_cast<int>(state.range(0)), static_cast<int>(state.range(1)));
+    PackedGrid board(TileSize, TileSize);
+    board.pack(tile);
+    std::vector<int> samples = sampleIndices(TileSize, TileSize);
+    std::vector<Pixel> display(TileCells);
+    ColorMapping<PackedGrid> colour(&board, display.data(), &samples, &samples);
+    tbb::blocked_range2d<int> range(0, TileSize, 0, TileSize);
+    for (auto _ : state){
+        colour(range);
+        benchmark::ClobberMemory();
+    }
+    reportPerCell(state, PackedColourBytes);
+}
+BENCHMARK(BM_ColorMappingPacked)->Apply(densityAndSpecies);
+
+BENCHMARK_MAIN();
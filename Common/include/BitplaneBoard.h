@@ -0,0 +1,44 @@
+#pragma once
+#include "Grid.h"
+#include <cstdint>
+#include <vector>
+
+// Board stored as one bitplane per species, 64 cells packed into each uint64_t.
+// Every row carries a guard word on both sides and there is a guard row above and
+// below, the words of all species for one (row, word) position sit next to each other.
+// The guards stay zero for a dead border, refreshHalo(Torus) fills them with the opposite
+// edge, column numCols() then lives in the unused bits of the last word when there are any.
+class BitplaneBoard {
+    private:
+        int rows;
+        int cols;
+        int numSpecies;
+        int words;      // words per row holding real cells
+        int rowWords;   // words per row including the guard words
+        uint64_t lastMask;
+        std::vector<uint64_t> planes;
+
+    public:
+        BitplaneBoard(int rows, int cols, int numSpecies);
+
+        int numRows() const { return rows; }
+        int numCols() const { return cols; }
+        int speciesCount() const { return numSpecies; }
+        int wordsPerRow() const { return words; }
+
+        // Pointer to the numSpecies words covering cells [64 * w, 64 * w + 63] of row r,
+        // w may be -1 or wordsPerRow() and r may be -1 or numRows() to reach the guards
+        uint64_t* word(int r, int w) { return &planes[(static_cast<size_t>(r + 1) * rowWords + (w + 1)) * numSpecies]; }
+        const uint64_t* word(int r, int w) const { return &planes[(static_cast<size_t>(r + 1) * rowWords + (w + 1)) * numSpecies]; }
+        uint64_t validMask(int w) const { return w == words - 1 ? lastMask : ~0ULL; }
+
+        void refreshHalo(Boundary boundary);
+        void load(const Grid& grid);
+        // Writes the words of rows [rowStart, rowEnd) whose first cell lies in [colStart, colEnd) back as bytes
+        void store(Grid& grid, int rowStart, int rowEnd, int colStart, int colEnd) const;
+};
+
+// Same contract as decide(), advances the words of rows [rowStart, rowEnd) whose first cell lies
+// in [colStart, colEnd), so like stepRowsPacked() column ranges never make two callers share a word.
+// seed and generation only feed tieBreak() so every engine picks the same species for a cell.
+void decideBitplane(const BitplaneBoard& foreground, BitplaneBoard& background, int rowStart, int rowEnd, int colStart, int colEnd, uint64_t seed, uint64_t generation);
@@ -0,0 +1,32 @@
+#pragma once
+#include <cstdint>
+
+// L2 traffic of the whole process from the hardware counters, read with perf_event_open on Linux.
+// Threads started after the counters are opened are counted with the one that opened them, so open
+// them before the worker threads exist. Elsewhere, or when the kernel or the VM gives no counters,
+// available() is false and every count is 0.
+//
+// The counters are the generic ones every PMU offers: L1 data read misses are the reads that go on
+// to L2, and last level cache references are the requests that missed L2 on their way there.
+class CacheCounters {
+    private:
+        int accessesFd;
+        int missesFd;
+
+        CacheCounters(const CacheCounters&) = delete;
+        CacheCounters& operator=(const CacheCounters&) = delete;
+
+    public:
+        CacheCounters();
+        ~CacheCounters();
+
+        bool available() const { return accessesFd >= 0 && missesFd >= 0; }
+        // Zeroes the counts and starts counting, stop() freezes them
+        void start();
+        void stop();
+        uint64_t l2Accesses() const;
+        uint64_t l2Misses() const;
+};
+
+// Prints the L2 misses per cell update and per L2 access, or why there are none
+void printCacheReport(const CacheCounters& counters, uint64_t cellUpdates);
@@ -0,0 +1,37 @@
+#pragma once
+#include "Grid.h"
+#include "PackedGrid.h"
+#include <cstdint>
+
+// A board laid out as the rows of a one byte integer texture, so the display can upload the cells
+// as they are and look their colours up in the fragment shader. A byte board gives one texel per
+// cell holding the int8_t state, a packed board one texel per two cells holding state + 1 in each
+// nibble, the even column in the low one.
+struct CellTexture {
+    const uint8_t* data;    // texel (0, 0), cell (0, 0) of the board
+    int width;              // texels across
+    int height;
+    int rowLength;          // texels from the start of one row to the next, for GL_UNPACK_ROW_LENGTH
+    bool packed;
+};
+
+inline CellTexture cellTexture(const Grid& board){
+    CellTexture texture;
+    texture.data = reinterpret_cast<const uint8_t*>(board.row(0));
+    texture.width = board.numCols();
+    texture.height = board.numRows();
+    texture.rowLength = board.rowPitch();
+    texture.packed = false;
+    return texture;
+}
+
+inline CellTexture cellTexture(const PackedGrid& board){
+    CellTexture texture;
+    texture.data = reinterpret_cast<const uint8_t*>(board.row(0));
+    texture.width = (board.numCols() + 1) / 2;
+    texture.height = board.numRows();
+    // Row numRows() is the ghost row, so row(1) is always there
+    texture.rowLength = static_cast<int>((board.row(1) - board.row(0)) * sizeof(uint64_t));
+    texture.packed = true;
+    return texture;
+}
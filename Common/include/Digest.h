@@ -0,0 +1,12 @@
+#pragma once
+#include "Grid.h"
+#include <cstdint>
+
+// 64-bit digest of a board's cells in row-major order. Rows are hashed one at a time, so a
+// padded Grid and a flat rows * cols array with the same cells give the same value.
+uint64_t digestRow(const int8_t* cells, int count, uint64_t hash);
+uint64_t boardDigest(const int8_t* cells, int rows, int cols);
+uint64_t boardDigest(const Grid& grid);
+
+// Prints "generation <n> digest <16 hex digits>", the same line in every app so runs can be diffed
+void printDigest(uint64_t generation, uint64_t digest);
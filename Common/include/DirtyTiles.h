@@ -0,0 +1,53 @@
+#pragma once
+#include "Grid.h"
+#include "PackedGrid.h"
+#include <cstdint>
+#include <vector>
+
+// Splits the board into square tiles and remembers which of them changed in the last generation.
+// The next generation of a tile can only differ from the current one when the tile or one of its
+// 8 neighbours changed, so every other tile is skipped and keeps the cells it already holds in
+// both buffers. Ties never break the rule: a tie always gives birth, so a tile holding one changed.
+class DirtyTiles {
+    private:
+        int rows;
+        int cols;
+        int tileSize;
+        int tileRows;   // tiles down the board
+        int tileCols;   // tiles across the board
+        Boundary boundary;
+        bool enabled;
+        std::vector<uint8_t> changed;   // one byte per tile so workers can write their own tiles
+        std::vector<uint8_t> activeMask;    // the tiles of activeTiles, one byte per tile
+        std::vector<int> activeTiles;
+        std::vector<int> changedTiles;
+
+    public:
+        // With enabled = false every tile is recomputed and redrawn each generation
+        DirtyTiles(int rows, int cols, int tileSize, Boundary boundary, bool enabled);
+
+        int count() const { return tileRows * tileCols; }
+        int size() const { return tileSize; }
+        int rowsOfTiles() const { return tileRows; }
+        int colsOfTiles() const { return tileCols; }
+        bool tracking() const { return enabled; }
+        void bounds(int tile, int& rowStart, int& rowEnd, int& colStart, int& colEnd) const;
+
+        // Marks the whole board as changed, after it was filled or loaded
+        void markAll();
+        void setChanged(int tile, bool value) { changed[tile] = value; }
+
+        // Tiles to recompute this generation, built from the changes of the last one.
+        // Clears the changes, the workers set them again for the tiles they run.
+        const std::vector<int>& collectActive();
+        // Whether the last collectActive() picked the tile, for passes that walk every tile in order
+        bool isActive(int tile) const { return activeMask[tile] != 0; }
+        // Tiles that changed in the last generation, the only ones the display has to redraw,
+        // so the display has to be drawn once per generation
+        const std::vector<int>& collectChanged();
+};
+
+// Whether any cell of the rectangle differs between the two boards
+bool tileChanged(const Grid& before, const Grid& after, int rowStart, int rowEnd, int colStart, int colEnd);
+// Same for packed boards, over the words whose first cell lies in [colStart, colEnd) like stepRowsPacked()
+bool tileChanged(const PackedGrid& before, const PackedGrid& after, int rowStart, int rowEnd, int colStart, int colEnd);
@@ -0,0 +1,78 @@
+#pragma once
+#include <cstdint>
+#include <cstddef>
+
+const int deadID = -1;
+const int8_t offsets[8][2] = {
+    {-1,  0},  // up
+    { 1,  0},  // down
+    { 0, -1},  // left
+    { 0,  1},  // right
+    {-1, -1},  // up-left
+    {-1,  1},  // up-right
+    { 1, -1},  // down-left
+    { 1,  1}   // down-right
+};
+
+// How the ghost border around the board is filled before each generation
+enum class Boundary { Dead, Torus };
+
+// Board of int8_t cells stored in one contiguous 64 byte aligned block.
+// Every row is surrounded by a ghost cell on each side and there is a ghost row
+// above and below the board, so at(-1, c) .. at(numRows, c) and at(r, -1) .. at(r, numCols)
+// are always valid and neighbours can be read without bounds checks.
+class Grid {
+    private:
+        int rows;
+        int cols;
+        int pitch;
+        int8_t* storage;
+        int8_t* origin; // cell (0, 0), always 64 byte aligned
+        int firstRow;   // board coordinates of cell (0, 0) when the grid is a window of a larger board
+        int firstCol;
+        int boardRows;
+        int boardCols;
+
+    public:
+        static const int Alignment = 64;
+
+        // pitch = 0 picks one automatically, otherwise it is rounded up to a multiple of Alignment.
+        // With fill = false no page is touched until fillRows() runs, so each thread can first-touch its own rows.
+        Grid(int rows, int cols, int pitch = 0, bool fill = true);
+        ~Grid();
+        Grid(const Grid&) = delete;
+        Grid& operator=(const Grid&) = delete;
+
+        int numRows() const { return rows; }
+        int numCols() const { return cols; }
+        int rowPitch() const { return pitch; }
+
+        int8_t* row(int r) { return origin + static_cast<std::ptrdiff_t>(r) * pitch; }
+        const int8_t* row(int r) const { return origin + static_cast<std::ptrdiff_t>(r) * pitch; }
+        int8_t& at(int r, int c) { return row(r)[c]; }
+        int8_t at(int r, int c) const { return row(r)[c]; }
+
+        // Makes the grid a window whose cell (0, 0) is cell (row, col) of a boardRows x boardCols board.
+        // Tie-breaks use board coordinates, wrapped around the board, so a window steps like the board.
+        void placeOnBoard(int row, int col, int boardRows, int boardCols);
+        int boardRow(int r) const { return wrap(firstRow + r, boardRows); }
+        int boardCol(int c) const { return wrap(firstCol + c, boardCols); }
+        static int wrap(int index, int size){
+            while (index < 0)
+                index += size;
+            while (index >= size)
+                index -= size;
+            return index;
+        }
+
+        // Distance in bytes from a cell to each of its neighbours, in the same order as offsets
+        void neighborOffsets(std::ptrdiff_t neighbors[8]) const;
+
+        // Sets rows [rowStart, rowEnd) to dead with their ghost cells, the ghost rows go with the first and last row
+        void fillRows(int rowStart, int rowEnd);
+
+        // Fills the ghost border, called once per generation on the grid about to be read
+        void refreshHalo(Boundary boundary);
+        void copyFrom(const Grid& other);
+        void swap(Grid& other);
+};
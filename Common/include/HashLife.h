@@ -0,0 +1,90 @@
+#pragma once
+#include "Grid.h"
+#include <cstdint>
+#include <cstddef>
+#include <unordered_map>
+#include <vector>
+
+// Hash-consed quadtree that jumps a board forward by powers of two generations, HashLife style.
+// Every distinct square of cells is stored once and remembers where its centre half ends up
+// 2^k generations later, so repeating and settled regions are only ever computed once.
+//
+// Tie-breaks depend on the cell's position and generation, so a result is only remembered on
+// the node when no tie happened while computing it; whether a tie happens depends on the cells
+// alone. Results that did tie are kept per position and generation for the current jump only.
+// Cells outside the board are a wall state that never changes and counts as dead, which gives
+// the same dead border as Grid. The torus has no equivalent here.
+class HashLife {
+    private:
+        struct Node {
+            uint32_t child[4];  // nw, ne, sw, se
+            uint32_t result;    // centre half after 2^resultStep generations, NoNode until computed
+            int8_t resultStep;
+            uint8_t level;      // side of 2^level cells
+        };
+        struct Key {
+            uint32_t child[4];
+            bool operator==(const Key& other) const;
+        };
+        struct KeyHash {
+            size_t operator()(const Key& key) const;
+        };
+        // A result that depends on where and when the node was advanced
+        struct PlacedKey {
+            uint32_t node;
+            int8_t step;
+            int64_t row;
+            int64_t col;
+            uint64_t generation;
+            bool operator==(const PlacedKey& other) const;
+        };
+        struct PlacedKeyHash {
+            size_t operator()(const PlacedKey& key) const;
+        };
+
+        static const uint32_t NoNode = 0xFFFFFFFFu;
+        static const int8_t WallState = 10;
+
+        int rows;
+        int cols;
+        int numSpecies;
+        uint64_t seed;
+        uint64_t generation;
+        int stepExponent;       // current jump is 2^stepExponent generations
+        int boardLevel;         // the board sits at (0, 0) of a node of this level
+        uint32_t board;
+        std::vector<Node> nodes;
+        std::unordered_map<Key, uint32_t, KeyHash> index;
+        std::unordered_map<PlacedKey, uint32_t, PlacedKeyHash> placed;
+        std::vector<uint32_t> walls;    // the all wall node of every level
+
+        void clear();
+        uint32_t leaf(int8_t state) const { return static_cast<uint32_t>(state + 1); }
+        int8_t state(uint32_t leafNode) const { return static_cast<int8_t>(leafNode) - 1; }
+        uint32_t join(uint32_t nw, uint32_t ne, uint32_t sw, uint32_t se);
+        uint32_t wall(int level);
+        uint32_t centre(uint32_t node);
+        uint32_t build(const int8_t* cells, int level, int64_t row, int64_t col);
+        void read(uint32_t node, int level, int64_t row, int64_t col, int8_t* cells) const;
+        uint32_t embed(int level, int64_t row, int64_t col);
+        uint32_t advance(uint32_t node, int level, int64_t row, int64_t col, uint64_t start, bool& tieFree);
+        uint32_t advanceBase(uint32_t node, int64_t row, int64_t col, uint64_t start, bool& tieFree);
+
+    public:
+        // Memory is given back by rebuilding the tree from the board once it holds this many nodes
+        static const size_t MaxNodes = 1 << 22;
+
+        HashLife(int rows, int cols, int numSpecies, uint64_t seed);
+
+        // Converters from and to the byte boards, flat ones are rows * cols cells in row-major order
+        void load(const Grid& grid, uint64_t generation);
+        void load(const int8_t* cells, uint64_t generation);
+        void store(Grid& grid) const;
+        void store(int8_t* cells) const;
+
+        uint64_t generationCount() const { return generation; }
+        size_t nodeCount() const { return nodes.size(); }
+
+        // Advances to the given generation in jumps of the largest powers of two that fit
+        void stepTo(uint64_t target);
+};
@@ -0,0 +1,55 @@
+#pragma once
+#include "Grid.h"
+#include <cstddef>
+#include <vector>
+
+// Hardware threads of the machine and the NUMA node of each, read from Linux sysfs.
+// Elsewhere the machine is one node of hardware_concurrency() threads and pinning does nothing.
+class Topology {
+    public:
+        struct Cpu {
+            int id;
+            int core;       // physical core, the same for SMT siblings
+            int node;
+            int sibling;    // 0 for the first hardware thread of its core
+        };
+
+    private:
+        std::vector<Cpu> cpus;
+        std::vector<int> nodeIds;
+        std::vector<std::vector<Cpu> > pinOrder;   // per node, one thread of every core before any sibling
+        Topology();
+
+    public:
+        static const Topology& machine();
+
+        int nodeCount() const { return static_cast<int>(nodeIds.size()); }
+        int cpuCount() const { return static_cast<int>(cpus.size()); }
+        int nodeOfCpu(int cpu) const;
+
+        // Where worker n of count goes. Workers are split into one contiguous block per node, so
+        // neighbouring row bands share a node, and a block uses every core before the SMT siblings.
+        const Cpu& cpuForWorker(int worker, int workers) const;
+};
+
+// Pins the calling thread to one hardware thread, false where the system does not allow it
+bool pinCurrentThread(int cpu);
+// Hardware thread the caller runs on, -1 when unknown
+int currentCpu();
+// NUMA node of every page of [data, data + bytes), -1 for pages never touched or when the system does not say
+std::vector<int> pageNodes(const void* data, size_t bytes);
+
+// What one worker saw streaming through its own row band
+struct BandReading {
+    int node;           // node the worker ran on
+    size_t bytes;       // bytes read in all passes
+    double seconds;
+    size_t pages;       // pages of the band
+    size_t localPages;  // of those, pages on the worker's node
+    uint64_t checksum;  // sum of the words read, returned so the reads cannot be optimised away
+};
+
+// Reads rows [rowStart, rowEnd) of grid passes times from the calling thread
+BandReading readBand(const Grid& grid, int rowStart, int rowEnd, int passes);
+// Prints, for every node, its share of the boards' pages and the read bandwidth of the workers on it
+void printNodeReport(const std::vector<BandReading>& readings, const std::vector<const Grid*>& boards);
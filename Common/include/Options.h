@@ -0,0 +1,51 @@
+#pragma once
+#include "Grid.h"
+#include <string>
+#include <cstdint>
+
+// Which kernel advances the board on the CPU
+enum class Engine { Scalar, Simd, Bitplane, Packed, Window };
+
+// How the A1 pool shares the tiles of a generation out: contiguous runs, round-robin, or runs
+// with idle workers stealing from the busy ones
+enum class Schedule { Static, Cyclic, Steal };
+
+// How A2 hands the tiles of a pass to the TBB workers: split on demand, back to the thread that
+// ran each tile last frame, or in fixed equal blocks
+enum class Partitioner { Auto, Affinity, Static };
+
+// Species a board can hold, bounded by the palette and the 4 bit packed cells
+const int MaxSpecies = 10;
+
+struct Options {
+    Engine engine = Engine::Scalar;
+    Boundary boundary = Boundary::Dead;
+    uint64_t seed = 0;      // drives the initial fill and every tie-break, taken from the clock unless --seed is given
+    int generations = 0;    // 0 runs until the window is closed, otherwise stop after this many and print a digest per generation
+    uint64_t fastForward = 0;   // generation to jump to with HashLife before the first step, where the engines support it
+
+    // Left at 0 each app keeps its own default
+    int width = 0;          // board columns
+    int height = 0;         // board rows
+    int species = 0;        // 1 .. MaxSpecies
+    int threads = 0;        // worker threads on the CPU
+    int tile = 0;           // edge of a tile in cells, the work-group edge for OpenCL
+    bool skipStable = true; // only recompute tiles next to a change, --skip-stable off runs every tile
+    Schedule schedule = Schedule::Steal;
+    Partitioner partitioner = Partitioner::Affinity;
+    bool numa = false;      // pin the CPU workers and let each one first-touch its own row band
+    bool numaReport = false;    // print where the board pages landed and the read bandwidth per node
+    int temporal = 0;       // generations a tile advances per pass in A2, 0 is one per pass, -1 picks it from the L2 size
+    bool pipeline = true;   // overlap simulating, colouring and presenting consecutive frames in A2
+    bool fused = false;     // colour each tile as soon as it is stepped instead of in a second sweep
+    bool shaderPalette = false; // upload the cells as they are and colour them in the fragment shader
+    bool pixelBuffers = true;   // stream display images to the texture through pixel buffer objects
+    bool headless = false;  // no window or GL at all, run --generations generations and print the throughput
+};
+
+// Parses "--name value" pairs and the bare --headless from the command line, unknown flags are reported and skipped
+Options parseOptions(int argc, char** argv);
+const char* engineName(Engine engine);
+const char* boundaryName(Boundary boundary);
+const char* scheduleName(Schedule schedule);
+const char* partitionerName(Partitioner partitioner);
@@ -0,0 +1,46 @@
+#pragma once
+#include "Grid.h"
+#include <cstdint>
+#include <cstddef>
+
+// Board with two cells per byte, each cell is a nibble holding state + 1 (0 = dead, 1..10 = species).
+// Rows are stored as uint64_t words of 16 cells, cell c of a row sits in bits 4 * (c % 16) of word c / 16.
+// Like Grid there is a ghost row above and below and a ghost cell on each side of every row,
+// the ghost at column -1 is the top nibble of word -1.
+class PackedGrid {
+    private:
+        int rows;
+        int cols;
+        int words;      // words per row holding real cells
+        int pitch;      // words between the starts of two rows
+        uint64_t* storage;
+        uint64_t* origin;
+
+    public:
+        static const int CellsPerWord = 16;
+
+        PackedGrid(int rows, int cols);
+        ~PackedGrid();
+        PackedGrid(const PackedGrid&) = delete;
+        PackedGrid& operator=(const PackedGrid&) = delete;
+
+        int numRows() const { return rows; }
+        int numCols() const { return cols; }
+        int wordsPerRow() const { return words; }
+        size_t bytes() const { return static_cast<size_t>(rows + 2) * pitch * sizeof(uint64_t); }
+
+        uint64_t* row(int r) { return origin + static_cast<std::ptrdiff_t>(r) * pitch; }
+        const uint64_t* row(int r) const { return origin + static_cast<std::ptrdiff_t>(r) * pitch; }
+
+        int8_t get(int r, int c) const;
+        void set(int r, int c, int8_t state);
+
+        void refreshHalo(Boundary boundary);
+        void pack(const Grid& grid);
+        void unpack(Grid& grid) const;
+};
+
+// Advances the words of rows [rowStart, rowEnd) whose first cell lies in [colStart, colEnd),
+// so column ranges that are not multiples of 16 never make two callers write the same word.
+// Works on 16 packed cells at a time, ties between species go through tieBreak().
+void stepRowsPacked(const PackedGrid& foreground, PackedGrid& background, int rowStart, int rowEnd, int colStart, int colEnd, int numSpecies, uint64_t seed, uint64_t generation);
@@ -0,0 +1,35 @@
+#pragma once
+#include "Options.h"
+#include <cstdint>
+
+// A display pixel in RGBA8 with red in the lowest byte, which is what GL_RGBA with
+// GL_UNSIGNED_INT_8_8_8_8_REV reads on any host, at a third of the size of three floats
+typedef uint32_t Pixel;
+
+// Packs a colour given as 0 .. 1 floats, rounded to the nearest step and fully opaque
+constexpr Pixel rgba(float r, float g, float b){
+    return static_cast<Pixel>(r * 255.0f + 0.5f) | static_cast<Pixel>(g * 255.0f + 0.5f) << 8 | static_cast<Pixel>(b * 255.0f + 0.5f) << 16 | 0xFF000000u;
+}
+
+// Indexed by cell + 1, the same as a packed nibble, so a dead cell needs no branch
+const Pixel colorMapping[MaxSpecies + 1] = {
+    rgba(0.0f, 0.0f, 0.0f),         // dead = Black
+    rgba(1.0f, 0.0f, 0.0f),         // 0 = Red
+    rgba(0.0f, 1.0f, 0.0f),         // 1 = Green
+    rgba(0.0f, 0.0f, 1.0f),         // 2 = Blue
+    rgba(1.0f, 1.0f, 0.0f),         // 3 = Yellow
+    rgba(0.0f, 1.0f, 1.0f),         // 4 = Cyan
+    rgba(1.0f, 0.0f, 1.0f),         // 5 = Magenta
+    rgba(1.0f, 0.647f, 0.0f),       // 6 = Orange
+    rgba(0.501f, 0.0f, 0.501f),     // 7 = Purple
+    rgba(1.0f, 0.752f, 0.796f),     // 8 = Pink
+    rgba(1.0f, 1.0f, 1.0f)          // 9 = White
+};
+
+// The palette as 0 .. 1 floats, for a vec4 uniform array when the fragment shader does the lookup
+inline void paletteColours(float colours[MaxSpecies + 1][4]){
+    for (int i = 0; i <= MaxSpecies; i++){
+        for (int channel = 0; channel < 4; channel++)
+            colours[i][channel] = ((colorMapping[i] >> (8 * channel)) & 0xFF) / 255.0f;
+    }
+}
@@ -0,0 +1,39 @@
+#pragma once
+#include <glad/glad.h>
+#include <cstddef>
+
+// Streams display images into a texture through a ring of pixel buffer objects. The image of
+// frame N is written straight into a mapped buffer while the GL still copies frame N - 1 out of
+// another one, so an upload returns as soon as the copy is queued instead of when the driver has
+// read client memory. Each buffer is fenced after its upload and mapped unsynchronized, so mapping
+// only ever waits on that fence, which has normally passed a frame ago. Needs a GL 3.2 context,
+// current on the calling thread; llvmpipe works too.
+//
+// A buffer keeps what was written into it, so callers that redraw only what changed since
+// a buffer was last drawn keep one record of that per slot, the same as for any set of images.
+class PixelStream {
+    private:
+        GLuint texture;
+        int width;
+        int height;
+        GLenum format;
+        GLenum type;
+        size_t bytes;
+        GLuint buffers[2];
+        GLsync fences[2];
+
+        PixelStream(const PixelStream&) = delete;
+        PixelStream& operator=(const PixelStream&) = delete;
+
+    public:
+        static const int Slots = 2;
+
+        // Images of width x height pixels of bytesPerPixel bytes, uploaded into texture with format and type
+        PixelStream(GLuint texture, int width, int height, GLenum format, GLenum type, size_t bytesPerPixel);
+        ~PixelStream();
+
+        // Maps buffer slot and returns its image, holding what was last written into it
+        void* map(int slot);
+        // Unmaps buffer slot and queues its upload into the texture
+        void upload(int slot);
+};
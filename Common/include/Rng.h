@@ -0,0 +1,42 @@
+#ifndef GOL_RNG_H
+#define GOL_RNG_H
+
+// Stateless counter-based generator shared by the CPU engines and the OpenCL kernels.
+// Every value is a pure function of (seed, generation, row, col), so the result does not
+// depend on which thread or work-item handles a cell and every engine picks the same species.
+// This file is compiled both as C++ and as OpenCL C, keep it to plain C.
+#ifdef __OPENCL_C_VERSION__
+typedef ulong rng_u64;
+typedef uint rng_u32;
+#define RNG_U64(x) x##UL
+#else
+#include <cstdint>
+typedef uint64_t rng_u64;
+typedef uint32_t rng_u32;
+#define RNG_U64(x) x##ULL
+#endif
+
+// SplitMix64 finaliser
+static inline rng_u64 rngMix(rng_u64 z){
+    z = (z ^ (z >> 30)) * RNG_U64(0xBF58476D1CE4E5B9);
+    z = (z ^ (z >> 27)) * RNG_U64(0x94D049BB133111EB);
+    return z ^ (z >> 31);
+}
+
+static inline rng_u64 cellRandom(rng_u64 seed, rng_u64 generation, int row, int col){
+    rng_u64 key = ((rng_u64)(rng_u32)row << 32) | (rng_u64)(rng_u32)col;
+    return rngMix(rngMix(seed + generation * RNG_U64(0x9E3779B97F4A7C15)) ^ key);
+}
+
+// Index in [0, count) of the birth candidate a dead cell takes when several species qualify
+static inline int tieBreak(rng_u64 seed, rng_u64 generation, int row, int col, int count){
+    return (int)(cellRandom(seed, generation, row, col) % (rng_u64)count);
+}
+
+// Species of a cell in the initial board, drawn from the stream of generation ~0 so it never
+// repeats a tie-break value
+static inline int initialState(rng_u64 seed, int row, int col, int numSpecies){
+    return (int)(cellRandom(seed, ~(rng_u64)0, row, col) % (rng_u64)numSpecies);
+}
+
+#endif
@@ -0,0 +1,47 @@
+#pragma once
+#include "Grid.h"
+#include <cstddef>
+#include <cstdint>
+
+enum class SimdLevel { Scalar, SSE2, AVX2, AVX512 };
+
+// Widest instruction set supported by both the build and the running CPU
+SimdLevel detectSimdLevel();
+const char* simdLevelName(SimdLevel level);
+
+// Next state of a single cell, used for row tails and for cells with several birth candidates.
+// Ties are settled by tieBreak() on (seed, generation, row, col) so every engine agrees.
+int8_t stepCellScalar(const int8_t* cell, const std::ptrdiff_t neighbors[8], int numSpecies, uint64_t seed, uint64_t generation, int row, int col);
+
+// Advances the cells in [rowStart, rowEnd) x [colStart, colEnd) of foreground into background,
+// 16 / 32 / 64 cells at a time depending on level. The halo of foreground must be refreshed first.
+// Ties use the board coordinates of the cell, which differ from the grid's own in a window.
+void stepRowsSimd(const Grid& foreground, Grid& background, int rowStart, int rowEnd, int colStart, int colEnd, int numSpecies, uint64_t seed, uint64_t generation, SimdLevel level);
+void stepRowsSimd(const Grid& foreground, Grid& background, int rowStart, int rowEnd, int colStart, int colEnd, int numSpecies, uint64_t seed, uint64_t generation);
+
+// The same pass one cell at a time, where there is no SSE2
+void stepRowsScalar(const Grid& foreground, Grid& background, int rowStart, int rowEnd, int colStart, int colEnd, int numSpecies, uint64_t seed, uint64_t generation);
+
+// One pass of the vector kernels as raw pointers and pitches. A kernel built with wider instructions
+// that called an inline Grid member would emit its own copy of it, and the linker may keep that copy
+// for the whole program, so those files only read this and leave the grids to SimdStep.cpp.
+struct SimdPass {
+    const Grid* foreground;
+    Grid* background;
+    const int8_t* cells;    // cell (0, 0) of foreground
+    int8_t* next;           // cell (0, 0) of background
+    std::ptrdiff_t cellsPitch;
+    std::ptrdiff_t nextPitch;
+    std::ptrdiff_t neighbors[8];
+    int numSpecies;
+    uint64_t seed;
+    uint64_t generation;
+};
+
+// stepCellScalar() of cell (row, col), tie-broken at its board coordinates
+int8_t stepCellPass(const SimdPass& pass, int row, int col);
+
+// One entry point per instruction set, each built in its own translation unit
+void stepRowsSSE2(const SimdPass& pass, int rowStart, int rowEnd, int colStart, int colEnd);
+void stepRowsAVX2(const SimdPass& pass, int rowStart, int rowEnd, int colStart, int colEnd);
+void stepRowsAVX512(const SimdPass& pass, int rowStart, int rowEnd, int colStart, int colEnd);
@@ -0,0 +1,47 @@
+#pragma once
+#include "Grid.h"
+#include "Options.h"
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+// Advances the board several generations per pass, one square tile at a time. Each tile is copied
+// into a scratch window with a halo of one cell per generation and stepped there while the window
+// stays in cache. The valid part of the window shrinks by a cell per generation, so after the pass
+// exactly the tile is left. Halo cells are computed by every tile whose window holds them, which
+// costs about ((tile + depth) / tile)^2 times the work of plain stepping.
+// Only the byte board engines, scalar, simd and window, can step a window.
+class TemporalTiles {
+    private:
+        int rows;
+        int cols;
+        int tileSize;
+        int depth;      // generations per pass
+        int tileRows;
+        int tileCols;
+        Boundary boundary;
+        Engine engine;
+
+    public:
+        // Pair of windows each worker steps its tiles in, kept between tiles and passes
+        struct Scratch {
+            std::unique_ptr<Grid> current;
+            std::unique_ptr<Grid> next;
+        };
+
+        TemporalTiles(int rows, int cols, int tileSize, int depth, Boundary boundary, Engine engine);
+
+        // Size of the per-core L2 cache, 1 MB when the system does not report it
+        static size_t cacheSize();
+        // Fills in the depth, and the tile edge when it is 0, so that a worker's two windows take
+        // half of cacheBytes and the halo adds about 15% of work
+        static void pickSizes(size_t cacheBytes, int& tileSize, int& depth);
+
+        int count() const { return tileRows * tileCols; }
+        int size() const { return tileSize; }
+        int generationsPerPass() const { return depth; }
+
+        // Advances tile t of foreground by generations (at most the depth) generations into background,
+        // starting at generation. Only the tile is written, so every tile runs before the boards swap.
+        void advanceTile(const Grid& foreground, Grid& background, int tile, int generations, int numSpecies, uint64_t seed, uint64_t generation, Scratch& scratch) const;
+};
@@ -0,0 +1,21 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+
+// Wall time of each step of a --headless run, a step being one or more generations
+class StepTimes {
+    private:
+        std::vector<double> seconds;
+        std::vector<int> generations;
+
+    public:
+        void add(double stepSeconds, int stepGenerations = 1);
+        uint64_t generationCount() const;
+        double totalSeconds() const;
+        // Seconds per generation of the step at fraction (0 .. 1) of the sorted steps
+        double percentile(double fraction) const;
+};
+
+// The line a --headless run ends with, the same in every app so runs and build servers can compare them:
+// "Headless: <n> generations in <s> s, <g> generations/s, <c> cells/s, step mean <m> ms p50 <p> ms p99 <q> ms"
+void printThroughput(const StepTimes& steps, int rows, int cols);
@@ -0,0 +1,14 @@
+#pragma once
+#include <vector>
+
+// Largest width x height with the board's aspect ratio that fits in maxWidth x maxHeight.
+// The board is only scaled up when grow is set, which suits the window but not the image
+// the board is drawn into.
+void fitInside(int cols, int rows, int maxWidth, int maxHeight, bool grow, int& width, int& height);
+
+// Board index sampled by each of displayCount pixels along one axis, nearest neighbour
+std::vector<int> sampleIndices(int count, int displayCount);
+
+// First display index whose sample falls in each tile of tileSize cells, plus samples.size() at the end,
+// so tile t covers display indices [starts[t], starts[t + 1])
+std::vector<int> tileStarts(const std::vector<int>& samples, int tileSize, int tileCount);
@@ -0,0 +1,10 @@
+#pragma once
+#include "Grid.h"
+#include <cstdint>
+
+// Advances [rowStart, rowEnd) x [colStart, colEnd) of foreground into background with a sliding window.
+// Every cell becomes a one-hot word holding a 4 bit counter per state, so the sum of three words is the
+// per-species count of a 3 cell column and the sum of three column counts is the whole neighbourhood.
+// Rows are done in pairs that share their two middle rows, each byte is loaded once per pair and the
+// column sums are kept in registers as the window slides along. The halo of foreground must be refreshed first.
+void stepRowsWindow(const Grid& foreground, Grid& background, int rowStart, int rowEnd, int colStart, int colEnd, int numSpecies, uint64_t seed, uint64_t generation);
@@ -0,0 +1,156 @@
+#include "../include/BitplaneBoard.h"
+#include "../include/Options.h"
+#include "../include/Rng.h"
+#include <algorithm>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+static int lowestBit(uint64_t bits){
+#if defined(_MSC_VER)
+    unsigned long index;
+    _BitScanForward64(&index, bits);
+    return static_cast<int>(index);
+#else
+    return __builtin_ctzll(bits);
+#endif
+}
+
+// Adds one neighbour bit to a 4 bit counter held across four words, one bit per cell
+static inline void addNeighbor(uint64_t x, uint64_t& b0, uint64_t& b1, uint64_t& b2, uint64_t& b3){
+    uint64_t c0 = b0 & x;
+    b0 ^= x;
+    uint64_t c1 = b1 & c0;
+    b1 ^= c0;
+    uint64_t c2 = b2 & c1;
+    b2 ^= c1;
+    b3 |= c2;
+}
+
+BitplaneBoard::BitplaneBoard(int rows, int cols, int numSpecies) : rows(rows), cols(cols), numSpecies(numSpecies) {
+    words = (cols + 63) / 64;
+    rowWords = words + 2;
+    lastMask = (cols % 64) ? (1ULL << (cols % 64)) - 1 : ~0ULL;
+    planes.assign(static_cast<size_t>(rows + 2) * rowWords * numSpecies, 0);
+}
+
+void BitplaneBoard::refreshHalo(Boundary boundary){
+    // Nothing ever writes the guards of a dead border
+    if (boundary == Boundary::Dead)
+        return;
+
+    // Wrap columns first so the row copies below also carry the corners
+    int rightWord = cols / 64;
+    int rightBit = cols % 64;
+    int lastWord = (cols - 1) / 64;
+    int lastBit = (cols - 1) % 64;
+    for (int r = 0; r < rows; r++){
+        uint64_t* left = word(r, -1);
+        uint64_t* right = word(r, rightWord);
+        const uint64_t* first = word(r, 0);
+        const uint64_t* last = word(r, lastWord);
+        for (int s = 0; s < numSpecies; s++){
+            left[s] = ((last[s] >> lastBit) & 1) << 63;
+            right[s] = (right[s] & ~(1ULL << rightBit)) | ((first[s] & 1) << rightBit);
+        }
+    }
+    std::copy(word(rows - 1, -1), word(rows - 1, -1) + static_cast<size_t>(rowWords) * numSpecies, word(-1, -1));
+    std::copy(word(0, -1), word(0, -1) + static_cast<size_t>(rowWords) * numSpecies, word(rows, -1));
+}
+
+void BitplaneBoard::load(const Grid& grid){
+    std::fill(planes.begin(), planes.end(), 0);
+    for (int r = 0; r < rows; r++){
+        const int8_t* cells = grid.row(r);
+        for (int c = 0; c < cols; c++){
+            if (cells[c] != deadID)
+                word(r, c / 64)[cells[c]] |= 1ULL << (c % 64);
+        }
+    }
+}
+
+void BitplaneBoard::store(Grid& grid, int rowStart, int rowEnd, int colStart, int colEnd) const {
+    int wordStart = (colStart + 63) / 64;
+    int wordEnd = (colEnd + 63) / 64;
+    int cellStart = wordStart * 64;
+    int cellEnd = wordEnd * 64 < cols ? wordEnd * 64 : cols;
+    for (int r = rowStart; r < rowEnd; r++){
+        int8_t* cells = grid.row(r);
+        for (int c = cellStart; c < cellEnd; c++)
+            cells[c] = deadID;
+        for (int w = wordStart; w < wordEnd; w++){
+            const uint64_t* planesAt = word(r, w);
+            for (int s = 0; s < numSpecies; s++){
+                // The unused bits of the last word may hold the wrapped first column
+                uint64_t bits = planesAt[s] & validMask(w);
+                while (bits){
+                    cells[w * 64 + lowestBit(bits)] = static_cast<int8_t>(s);
+                    bits &= bits - 1;
+                }
+            }
+        }
+    }
+}
+
+void decideBitplane(const BitplaneBoard& foreground, BitplaneBoard& background, int rowStart, int rowEnd, int colStart, int colEnd, uint64_t seed, uint64_t generation){
+    int numSpecies = foreground.speciesCount();
+    int wordStart = (colStart + 63) / 64;
+    int wordEnd = (colEnd + 63) / 64;
+
+    for (int r = rowStart; r < rowEnd; r++){
+        for (int w = wordStart; w < wordEnd; w++){
+            // Left, centre and right words of the rows above, at and below r
+            const uint64_t* up[3] = { foreground.word(r - 1, w - 1), foreground.word(r - 1, w), foreground.word(r - 1, w + 1) };
+            const uint64_t* mid[3] = { foreground.word(r, w - 1), foreground.word(r, w), foreground.word(r, w + 1) };
+            const uint64_t* down[3] = { foreground.word(r + 1, w - 1), foreground.word(r + 1, w), foreground.word(r + 1, w + 1) };
+            uint64_t* next = background.word(r, w);
+
+            uint64_t alive = 0;
+            for (int s = 0; s < numSpecies; s++)
+                alive |= mid[1][s];
+
+            uint64_t births[MaxSpecies];
+            uint64_t anyBirth = 0;
+            uint64_t ties = 0;
+
+            for (int s = 0; s < numSpecies; s++){
+                uint64_t b0 = 0, b1 = 0, b2 = 0, b3 = 0;
+                // Bit j of a west shifted word holds column j - 1, of an east shifted word column j + 1
+                addNeighbor((up[1][s] << 1) | (up[0][s] >> 63), b0, b1, b2, b3);
+                addNeighbor(up[1][s], b0, b1, b2, b3);
+                addNeighbor((up[1][s] >> 1) | (up[2][s] << 63), b0, b1, b2, b3);
+                addNeighbor((mid[1][s] << 1) | (mid[0][s] >> 63), b0, b1, b2, b3);
+                addNeighbor((mid[1][s] >> 1) | (mid[2][s] << 63), b0, b1, b2, b3);
+                addNeighbor((down[1][s] << 1) | (down[0][s] >> 63), b0, b1, b2, b3);
+                addNeighbor(down[1][s], b0, b1, b2, b3);
+                addNeighbor((down[1][s] >> 1) | (down[2][s] << 63), b0, b1, b2, b3);
+
+                // Count of 2 or 3, b0 tells them apart
+                uint64_t twoOrThree = b1 & ~b2 & ~b3;
+                uint64_t birth = ~alive & twoOrThree & b0 & foreground.validMask(w);
+
+                next[s] = mid[1][s] & twoOrThree;
+                births[s] = birth;
+                ties |= anyBirth & birth;
+                anyBirth |= birth;
+            }
+
+            for (int s = 0; s < numSpecies; s++)
+                next[s] |= births[s] & ~ties;
+
+            // Cells where several species qualify pick one of them per cell
+            while (ties){
+                int bit = lowestBit(ties);
+                int candidates[MaxSpecies];
+                int candidateCount = 0;
+                for (int s = 0; s < numSpecies; s++){
+                    if ((births[s] >> bit) & 1)
+                        candidates[candidateCount++] = s;
+                }
+                int species = candidates[tieBreak(seed, generation, r, w * 64 + bit, candidateCount)];
+                next[species] |= 1ULL << bit;
+                ties &= ties - 1;
+            }
+        }
+    }
+}
@@ -0,0 +1,99 @@
+#include "../include/CacheCounters.h"
+#include <cstring>
+#include <iostream>
+#if defined(__linux__)
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+#if defined(__linux__)
+// One counter of this process and the threads it starts from now on, created stopped
+static int openCounter(uint32_t type, uint64_t config){
+    perf_event_attr attr;
+    std::memset(&attr, 0, sizeof(attr));
+    attr.size = sizeof(attr);
+    attr.type = type;
+    attr.config = config;
+    attr.disabled = 1;
+    attr.inherit = 1;
+    attr.exclude_kernel = 1;
+    attr.exclude_hv = 1;
+    return static_cast<int>(syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0));
+}
+
+static uint64_t readCounter(int fd){
+    uint64_t value = 0;
+    if (fd < 0 || read(fd, &value, sizeof(value)) != static_cast<ssize_t>(sizeof(value)))
+        return 0;
+    return value;
+}
+#endif
+
+CacheCounters::CacheCounters() : accessesFd(-1), missesFd(-1) {
+#if defined(__linux__)
+    accessesFd = openCounter(PERF_TYPE_HW_CACHE, PERF_COUNT_HW_CACHE_L1D | (PERF_COUNT_HW_CACHE_OP_READ << 8) | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16));
+    missesFd = openCounter(PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_REFERENCES);
+#endif
+}
+
+CacheCounters::~CacheCounters(){
+#if defined(__linux__)
+    if (accessesFd >= 0)
+        close(accessesFd);
+    if (missesFd >= 0)
+        close(missesFd);
+#endif
+}
+
+void CacheCounters::start(){
+#if defined(__linux__)
+    if (!available())
+        return;
+    ioctl(accessesFd, PERF_EVENT_IOC_RESET, 0);
+    ioctl(missesFd, PERF_EVENT_IOC_RESET, 0);
+    ioctl(accessesFd, PERF_EVENT_IOC_ENABLE, 0);
+    ioctl(missesFd, PERF_EVENT_IOC_ENABLE, 0);
+#endif
+}
+
+void CacheCounters::stop(){
+#if defined(__linux__)
+    if (!available())
+        return;
+    ioctl(accessesFd, PERF_EVENT_IOC_DISABLE, 0);
+    ioctl(missesFd, PERF_EVENT_IOC_DISABLE, 0);
+#endif
+}
+
+uint64_t CacheCounters::l2Accesses() const {
+#if defined(__linux__)
+    return available() ? readCounter(accessesFd) : 0;
+#else
+    return 0;
+#endif
+}
+
+uint64_t CacheCounters::l2Misses() const {
+#if defined(__linux__)
+    return available() ? readCounter(missesFd) : 0;
+#else
+    return 0;
+#endif
+}
+
+void printCacheReport(const CacheCounters& counters, uint64_t cellUpdates){
+    if (!counters.available()){
+        std::cout << "L2: no hardware cache counters on this system\n";
+        return;
+    }
+    uint64_t accesses = counters.l2Accesses();
+    uint64_t misses = counters.l2Misses();
+    std::cout << "L2: " << misses << " misses of " << accesses << " accesses";
+    if (accesses > 0)
+        std::cout << ", " << 100.0 * misses / accesses << "% miss rate";
+    if (cellUpdates > 0)
+        std::cout << ", " << 1000.0 * misses / cellUpdates << " misses per 1000 cell updates";
+    std::cout << "\n";
+}
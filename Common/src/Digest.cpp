@@ -0,0 +1,42 @@
+#include "../include/Digest.h"
+#include "../include/Rng.h"
+#include <cstring>
+#include <cstdio>
+
+const uint64_t digestMultiplier = 0x9FB21C651E98DF25ULL;
+
+static inline uint64_t rotateLeft(uint64_t x, int bits){
+    return (x << bits) | (x >> (64 - bits));
+}
+
+uint64_t digestRow(const int8_t* cells, int count, uint64_t hash){
+    // Eight cells per multiply, the tail is zero padded and the length mixed in
+    int i = 0;
+    for (; i + 8 <= count; i += 8){
+        uint64_t word;
+        std::memcpy(&word, cells + i, sizeof(word));
+        hash = rotateLeft(hash ^ (word * digestMultiplier), 29) * digestMultiplier;
+    }
+    uint64_t tail = 0;
+    std::memcpy(&tail, cells + i, count - i);
+    hash = rotateLeft(hash ^ (tail * digestMultiplier), 29) * digestMultiplier;
+    return rngMix(hash ^ static_cast<uint64_t>(count));
+}
+
+uint64_t boardDigest(const int8_t* cells, int rows, int cols){
+    uint64_t hash = static_cast<uint64_t>(rows) << 32 | static_cast<uint32_t>(cols);
+    for (int r = 0; r < rows; r++)
+        hash = digestRow(cells + static_cast<size_t>(r) * cols, cols, hash);
+    return hash;
+}
+
+uint64_t boardDigest(const Grid& grid){
+    uint64_t hash = static_cast<uint64_t>(grid.numRows()) << 32 | static_cast<uint32_t>(grid.numCols());
+    for (int r = 0; r < grid.numRows(); r++)
+        hash = digestRow(grid.row(r), grid.numCols(), hash);
+    return hash;
+}
+
+void printDigest(uint64_t generation, uint64_t digest){
+    std::printf("generation %llu digest %016llx\n", static_cast<unsigned long long>(generation), static_cast<unsigned long long>(digest));
+}
@@ -0,0 +1,84 @@
+#include "../include/DirtyTiles.h"
+#include <cstring>
+
+DirtyTiles::DirtyTiles(int rows, int cols, int tileSize, Boundary boundary, bool enabled) : rows(rows), cols(cols), tileSize(tileSize), boundary(boundary), enabled(enabled) {
+    tileRows = (rows + tileSize - 1) / tileSize;
+    tileCols = (cols + tileSize - 1) / tileSize;
+    changed.assign(count(), 1);
+    activeMask.assign(count(), 0);
+}
+
+void DirtyTiles::bounds(int tile, int& rowStart, int& rowEnd, int& colStart, int& colEnd) const {
+    rowStart = (tile / tileCols) * tileSize;
+    colStart = (tile % tileCols) * tileSize;
+    rowEnd = rowStart + tileSize < rows ? rowStart + tileSize : rows;
+    colEnd = colStart + tileSize < cols ? colStart + tileSize : cols;
+}
+
+void DirtyTiles::markAll(){
+    std::fill(changed.begin(), changed.end(), 1);
+}
+
+const std::vector<int>& DirtyTiles::collectActive(){
+    activeTiles.clear();
+    for (int tr = 0; tr < tileRows; tr++){
+        for (int tc = 0; tc < tileCols; tc++){
+            bool active = !enabled;
+            for (int dr = -1; dr <= 1 && !active; dr++){
+                for (int dc = -1; dc <= 1 && !active; dc++){
+                    int r = tr + dr;
+                    int c = tc + dc;
+                    // On a torus the tiles along one edge neighbour the tiles along the other
+                    if (boundary == Boundary::Torus){
+                        r = (r + tileRows) % tileRows;
+                        c = (c + tileCols) % tileCols;
+                    }
+                    else if (r < 0 || r >= tileRows || c < 0 || c >= tileCols)
+                        continue;
+                    active = changed[r * tileCols + c] != 0;
+                }
+            }
+            activeMask[tr * tileCols + tc] = active;
+            if (active)
+                activeTiles.push_back(tr * tileCols + tc);
+        }
+    }
+    std::fill(changed.begin(), changed.end(), 0);
+    return activeTiles;
+}
+
+const std::vector<int>& DirtyTiles::collectChanged(){
+    changedTiles.clear();
+    for (int t = 0; t < count(); t++){
+        if (changed[t] || !enabled)
+            changedTiles.push_back(t);
+    }
+    return changedTiles;
+}
+
+bool tileChanged(const Grid& before, const Grid& after, int rowStart, int rowEnd, int colStart, int colEnd){
+    for (int r = rowStart; r < rowEnd; r++){
+        if (std::memcmp(before.row(r) + colStart, after.row(r) + colStart, colEnd - colStart) != 0)
+            return true;
+    }
+    return false;
+}
+
+bool tileChanged(const PackedGrid& before, const PackedGrid& after, int rowStart, int rowEnd, int colStart, int colEnd){
+    const int cellsPerWord = PackedGrid::CellsPerWord;
+    int wordStart = (colStart + cellsPerWord - 1) / cellsPerWord;
+    int wordEnd = (colEnd + cellsPerWord - 1) / cellsPerWord;
+    // The spare nibbles of the last word hold the ghost column, which is not part of the board
+    int spare = before.numCols() % cellsPerWord;
+    uint64_t lastMask = spare ? (1ULL << (spare * 4)) - 1 : ~0ULL;
+    for (int r = rowStart; r < rowEnd; r++){
+        const uint64_t* a = before.row(r);
+        const uint64_t* b = after.row(r);
+        for (int w = wordStart; w < wordEnd; w++){
+            uint64_t mask = w == before.wordsPerRow() - 1 ? lastMask : ~0ULL;
+            if ((a[w] ^ b[w]) & mask)
+                return true;
+        }
+    }
+    return false;
+}
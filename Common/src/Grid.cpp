@@ -0,0 +1,88 @@
+#include "../include/Grid.h"
+#include <cstring>
+#include <utility>
+
+static int roundUp(int value, int multiple){
+    return (value + multiple - 1) / multiple * multiple;
+}
+
+Grid::Grid(int rows, int cols, int pitch, bool fill) : rows(rows), cols(cols), firstRow(0), firstCol(0), boardRows(rows), boardCols(cols) {
+    // Left padding up to the alignment boundary holds the left ghost cell, the right ghost follows the last column
+    int minPitch = roundUp(Alignment + cols + 1, Alignment);
+    if (pitch <= 0){
+        pitch = minPitch;
+        // Strides that are a multiple of 1K map neighbouring rows onto the same cache sets
+        if (pitch % 1024 == 0)
+            pitch += Alignment;
+    }
+    this->pitch = roundUp(pitch < minPitch ? minPitch : pitch, Alignment);
+
+    // Ghost row above and below, slack at the end so vector loads past the last column stay in bounds
+    size_t bytes = static_cast<size_t>(rows + 2) * this->pitch + 2 * Alignment;
+    storage = new int8_t[bytes + Alignment];
+    int8_t* aligned = reinterpret_cast<int8_t*>((reinterpret_cast<uintptr_t>(storage) + Alignment - 1) & ~static_cast<uintptr_t>(Alignment - 1));
+    origin = aligned + this->pitch + Alignment;
+    if (fill)
+        std::memset(aligned, deadID, bytes);
+}
+
+void Grid::fillRows(int rowStart, int rowEnd){
+    // Each row owns its pitch starting at its left padding, the first and last rows also own the ends of the block
+    int8_t* start = rowStart == 0 ? row(-1) - Alignment : row(rowStart) - Alignment;
+    int8_t* end = rowEnd == rows ? row(rows + 1) + Alignment : row(rowEnd) - Alignment;
+    if (start < end)
+        std::memset(start, deadID, end - start);
+}
+
+Grid::~Grid(){
+    delete [] storage;
+}
+
+void Grid::placeOnBoard(int row, int col, int boardRows, int boardCols){
+    firstRow = row;
+    firstCol = col;
+    this->boardRows = boardRows;
+    this->boardCols = boardCols;
+}
+
+void Grid::neighborOffsets(std::ptrdiff_t neighbors[8]) const {
+    for (int i = 0; i < 8; i++)
+        neighbors[i] = static_cast<std::ptrdiff_t>(offsets[i][0]) * pitch + offsets[i][1];
+}
+
+void Grid::refreshHalo(Boundary boundary){
+    if (boundary == Boundary::Dead){
+        for (int r = 0; r < rows; r++){
+            row(r)[-1] = deadID;
+            row(r)[cols] = deadID;
+        }
+        std::memset(row(-1) - 1, deadID, cols + 2);
+        std::memset(row(rows) - 1, deadID, cols + 2);
+        return;
+    }
+
+    // Wrap columns first so the row copies below also carry the corners
+    for (int r = 0; r < rows; r++){
+        row(r)[-1] = row(r)[cols - 1];
+        row(r)[cols] = row(r)[0];
+    }
+    std::memcpy(row(-1) - 1, row(rows - 1) - 1, cols + 2);
+    std::memcpy(row(rows) - 1, row(0) - 1, cols + 2);
+}
+
+void Grid::copyFrom(const Grid& other){
+    for (int r = -1; r <= rows; r++)
+        std::memcpy(row(r) - 1, other.row(r) - 1, cols + 2);
+}
+
+void Grid::swap(Grid& other){
+    std::swap(rows, other.rows);
+    std::swap(cols, other.cols);
+    std::swap(pitch, other.pitch);
+    std::swap(storage, other.storage);
+    std::swap(origin, other.origin);
+    std::swap(firstRow, other.firstRow);
+    std::swap(firstCol, other.firstCol);
+    std::swap(boardRows, other.boardRows);
+    std::swap(boardCols, other.boardCols);
+}
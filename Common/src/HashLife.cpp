@@ -0,0 +1,304 @@
+#include "../include/HashLife.h"
+#include "../include/Options.h"
+#include "../include/Rng.h"
+#include <iostream>
+
+bool HashLife::Key::operator==(const Key& other) const {
+    return child[0] == other.child[0] && child[1] == other.child[1] && child[2] == other.child[2] && child[3] == other.child[3];
+}
+
+size_t HashLife::KeyHash::operator()(const Key& key) const {
+    uint64_t low = (static_cast<uint64_t>(key.child[0]) << 32) | key.child[1];
+    uint64_t high = (static_cast<uint64_t>(key.child[2]) << 32) | key.child[3];
+    return static_cast<size_t>(rngMix(low ^ rngMix(high)));
+}
+
+bool HashLife::PlacedKey::operator==(const PlacedKey& other) const {
+    return node == other.node && step == other.step && row == other.row && col == other.col && generation == other.generation;
+}
+
+size_t HashLife::PlacedKeyHash::operator()(const PlacedKey& key) const {
+    uint64_t hash = rngMix((static_cast<uint64_t>(key.node) << 8) | static_cast<uint8_t>(key.step));
+    hash = rngMix(hash ^ static_cast<uint64_t>(key.row));
+    hash = rngMix(hash ^ static_cast<uint64_t>(key.col));
+    return static_cast<size_t>(rngMix(hash ^ key.generation));
+}
+
+HashLife::HashLife(int rows, int cols, int numSpecies, uint64_t seed) : rows(rows), cols(cols), numSpecies(numSpecies), seed(seed), generation(0), stepExponent(0) {
+    // Smallest square holding the board, at least 4 x 4 so the base case always has a centre
+    boardLevel = 2;
+    while ((static_cast<int64_t>(1) << boardLevel) < rows || (static_cast<int64_t>(1) << boardLevel) < cols)
+        boardLevel++;
+    clear();
+}
+
+void HashLife::clear(){
+    nodes.clear();
+    index.clear();
+    placed.clear();
+    walls.clear();
+    // Nodes 0 .. WallState + 1 are the single cells, dead first
+    for (int s = deadID; s <= WallState; s++){
+        Node cell = {{NoNode, NoNode, NoNode, NoNode}, NoNode, -1, 0};
+        nodes.push_back(cell);
+    }
+    walls.push_back(leaf(WallState));
+    board = wall(boardLevel);
+}
+
+uint32_t HashLife::join(uint32_t nw, uint32_t ne, uint32_t sw, uint32_t se){
+    Key key = {{nw, ne, sw, se}};
+    std::unordered_map<Key, uint32_t, KeyHash>::const_iterator found = index.find(key);
+    if (found != index.end())
+        return found->second;
+    Node node = {{nw, ne, sw, se}, NoNode, -1, static_cast<uint8_t>(nodes[nw].level + 1)};
+    uint32_t id = static_cast<uint32_t>(nodes.size());
+    nodes.push_back(node);
+    index.emplace(key, id);
+    return id;
+}
+
+uint32_t HashLife::wall(int level){
+    while (static_cast<int>(walls.size()) <= level){
+        uint32_t below = walls.back();
+        walls.push_back(join(below, below, below, below));
+    }
+    return walls[level];
+}
+
+uint32_t HashLife::centre(uint32_t node){
+    const Node& n = nodes[node];
+    uint32_t nw = nodes[n.child[0]].child[3];
+    uint32_t ne = nodes[n.child[1]].child[2];
+    uint32_t sw = nodes[n.child[2]].child[1];
+    uint32_t se = nodes[n.child[3]].child[0];
+    return join(nw, ne, sw, se);
+}
+
+uint32_t HashLife::build(const int8_t* cells, int level, int64_t row, int64_t col){
+    if (row >= rows || col >= cols)
+        return wall(level);
+    if (level == 0)
+        return leaf(cells[row * cols + col]);
+    int64_t half = static_cast<int64_t>(1) << (level - 1);
+    uint32_t nw = build(cells, level - 1, row, col);
+    uint32_t ne = build(cells, level - 1, row, col + half);
+    uint32_t sw = build(cells, level - 1, row + half, col);
+    uint32_t se = build(cells, level - 1, row + half, col + half);
+    return join(nw, ne, sw, se);
+}
+
+void HashLife::read(uint32_t node, int level, int64_t row, int64_t col, int8_t* cells) const {
+    if (row >= rows || col >= cols)
+        return;
+    if (level == 0){
+        cells[row * cols + col] = state(node);
+        return;
+    }
+    int64_t half = static_cast<int64_t>(1) << (level - 1);
+    const Node& n = nodes[node];
+    read(n.child[0], level - 1, row, col, cells);
+    read(n.child[1], level - 1, row, col + half, cells);
+    read(n.child[2], level - 1, row + half, col, cells);
+    read(n.child[3], level - 1, row + half, col + half, cells);
+}
+
+void HashLife::load(const int8_t* cells, uint64_t generation){
+    clear();
+    board = build(cells, boardLevel, 0, 0);
+    this->generation = generation;
+}
+
+void HashLife::load(const Grid& grid, uint64_t generation){
+    std::vector<int8_t> cells(static_cast<size_t>(rows) * cols);
+    for (int r = 0; r < rows; r++){
+        const int8_t* row = grid.row(r);
+        std::copy(row, row + cols, cells.begin() + static_cast<size_t>(r) * cols);
+    }
+    load(cells.data(), generation);
+}
+
+void HashLife::store(int8_t* cells) const {
+    read(board, boardLevel, 0, 0, cells);
+}
+
+void HashLife::store(Grid& grid) const {
+    std::vector<int8_t> cells(static_cast<size_t>(rows) * cols);
+    store(cells.data());
+    for (int r = 0; r < rows; r++)
+        std::copy(cells.begin() + static_cast<size_t>(r) * cols, cells.begin() + static_cast<size_t>(r + 1) * cols, grid.row(r));
+}
+
+// Node of the given level holding the board at (row, col) and walls everywhere else.
+// row and col are multiples of the board's side, so the board never straddles two quadrants.
+uint32_t HashLife::embed(int level, int64_t row, int64_t col){
+    if (level == boardLevel)
+        return board;
+    int64_t half = static_cast<int64_t>(1) << (level - 1);
+    uint32_t quadrants[4];
+    for (int q = 0; q < 4; q++){
+        int64_t top = (q / 2) * half;
+        int64_t left = (q % 2) * half;
+        if (row >= top && row < top + half && col >= left && col < left + half)
+            quadrants[q] = embed(level - 1, row - top, col - left);
+        else
+            quadrants[q] = wall(level - 1);
+    }
+    return join(quadrants[0], quadrants[1], quadrants[2], quadrants[3]);
+}
+
+// Centre 2 x 2 of a 4 x 4 node after one generation, the same rule as decide()
+uint32_t HashLife::advanceBase(uint32_t node, int64_t row, int64_t col, uint64_t start, bool& tieFree){
+    int8_t cells[4][4];
+    const Node& n = nodes[node];
+    for (int q = 0; q < 4; q++){
+        const Node& quarter = nodes[n.child[q]];
+        for (int c = 0; c < 4; c++)
+            cells[(q / 2) * 2 + c / 2][(q % 2) * 2 + c % 2] = state(quarter.child[c]);
+    }
+
+    uint32_t next[4];
+    for (int i = 1; i <= 2; i++){
+        for (int j = 1; j <= 2; j++){
+            int cellStatus = cells[i][j];
+            int result = cellStatus;
+            if (cellStatus != WallState){
+                int neighborCount = 0;
+                int speciesCounter[MaxSpecies] = {0};
+                for (int k = 0; k < 8; k++){
+                    int neighbor = cells[i + offsets[k][0]][j + offsets[k][1]];
+                    neighborCount += (neighbor == cellStatus);
+                    if (neighbor != deadID && neighbor != WallState)
+                        speciesCounter[neighbor]++;
+                }
+                if (cellStatus == deadID){
+                    int candidates[MaxSpecies];
+                    int candidateCount = 0;
+                    for (int s = 0; s < numSpecies; s++){
+                        if (speciesCounter[s] == 3)
+                            candidates[candidateCount++] = s;
+                    }
+                    if (candidateCount > 1){
+                        tieFree = false;
+                        result = candidates[tieBreak(seed, start, static_cast<int>(row + i), static_cast<int>(col + j), candidateCount)];
+                    }
+                    else if (candidateCount == 1)
+                        result = candidates[0];
+                }
+                else if (neighborCount < 2 || neighborCount > 3)
+                    result = deadID;
+            }
+            next[(i - 1) * 2 + (j - 1)] = leaf(static_cast<int8_t>(result));
+        }
+    }
+    return join(next[0], next[1], next[2], next[3]);
+}
+
+// Centre half of a node whose top left cell is (row, col), 2^min(stepExponent, level - 2)
+// generations after generation start
+uint32_t HashLife::advance(uint32_t node, int level, int64_t row, int64_t col, uint64_t start, bool& tieFree){
+    if (node == wall(level))
+        return wall(level - 1);
+    int8_t step = static_cast<int8_t>(stepExponent < level - 2 ? stepExponent : level - 2);
+    if (nodes[node].result != NoNode && nodes[node].resultStep == step)
+        return nodes[node].result;
+    PlacedKey key = {node, step, row, col, start};
+    std::unordered_map<PlacedKey, uint32_t, PlacedKeyHash>::const_iterator found = placed.find(key);
+    if (found != placed.end()){
+        tieFree = false;
+        return found->second;
+    }
+
+    bool ownTieFree = true;
+    uint32_t result;
+    if (level == 2)
+        result = advanceBase(node, row, col, start, ownTieFree);
+    else{
+        // Nine overlapping squares of half the side, quarter q apart
+        Node n = nodes[node];
+        const Node& nw = nodes[n.child[0]];
+        const Node& ne = nodes[n.child[1]];
+        const Node& sw = nodes[n.child[2]];
+        const Node& se = nodes[n.child[3]];
+        uint32_t squares[9] = {
+            n.child[0], 0, n.child[1],
+            0, 0, 0,
+            n.child[2], 0, n.child[3]
+        };
+        uint32_t grand[4][4] = {
+            {nw.child[0], nw.child[1], ne.child[0], ne.child[1]},
+            {nw.child[2], nw.child[3], ne.child[2], ne.child[3]},
+            {sw.child[0], sw.child[1], se.child[0], se.child[1]},
+            {sw.child[2], sw.child[3], se.child[2], se.child[3]}
+        };
+        squares[1] = join(grand[0][1], grand[0][2], grand[1][1], grand[1][2]);
+        squares[3] = join(grand[1][0], grand[1][1], grand[2][0], grand[2][1]);
+        squares[4] = join(grand[1][1], grand[1][2], grand[2][1], grand[2][2]);
+        squares[5] = join(grand[1][2], grand[1][3], grand[2][2], grand[2][3]);
+        squares[7] = join(grand[2][1], grand[2][2], grand[3][1], grand[3][2]);
+
+        int64_t quarter = static_cast<int64_t>(1) << (level - 2);
+        // At full speed both halves of the jump advance, otherwise the first one only takes the centres
+        bool fullSpeed = step == level - 2;
+        uint64_t middle = fullSpeed ? start + (static_cast<uint64_t>(1) << (level - 3)) : start;
+        uint32_t partial[9];
+        for (int k = 0; k < 9; k++){
+            if (fullSpeed)
+                partial[k] = advance(squares[k], level - 1, row + (k / 3) * quarter, col + (k % 3) * quarter, start, ownTieFree);
+            else
+                partial[k] = centre(squares[k]);
+        }
+
+        uint32_t quadrants[4];
+        for (int q = 0; q < 4; q++){
+            int top = q / 2;
+            int left = q % 2;
+            uint32_t joined = join(partial[top * 3 + left], partial[top * 3 + left + 1], partial[(top + 1) * 3 + left], partial[(top + 1) * 3 + left + 1]);
+            quadrants[q] = advance(joined, level - 1, row + quarter / 2 + top * quarter, col + quarter / 2 + left * quarter, middle, ownTieFree);
+        }
+        result = join(quadrants[0], quadrants[1], quadrants[2], quadrants[3]);
+    }
+
+    if (ownTieFree){
+        nodes[node].result = result;
+        nodes[node].resultStep = step;
+    }
+    else{
+        placed.emplace(key, result);
+        tieFree = false;
+    }
+    return result;
+}
+
+void HashLife::stepTo(uint64_t target){
+    if (target < generation){
+        std::cerr << "HashLife cannot go back from generation " << generation << " to " << target << "\n";
+        return;
+    }
+    while (generation < target){
+        uint64_t remaining = target - generation;
+        stepExponent = 0;
+        while (stepExponent < 62 && (static_cast<uint64_t>(1) << (stepExponent + 1)) <= remaining)
+            stepExponent++;
+
+        // The root's centre half has to hold the board and its level has to allow the jump
+        int level = boardLevel + 2 > stepExponent + 2 ? boardLevel + 2 : stepExponent + 2;
+        int64_t quarter = static_cast<int64_t>(1) << (level - 2);
+        uint32_t root = embed(level, quarter, quarter);
+        bool tieFree = true;
+        uint32_t result = advance(root, level, -quarter, -quarter, generation, tieFree);
+        generation += static_cast<uint64_t>(1) << stepExponent;
+
+        // The result starts at (0, 0), so the board is in its top left corner
+        for (int l = level - 1; l > boardLevel; l--)
+            result = nodes[result].child[0];
+        board = result;
+        placed.clear();
+
+        if (nodes.size() > MaxNodes){
+            std::vector<int8_t> cells(static_cast<size_t>(rows) * cols);
+            store(cells.data());
+            load(cells.data(), generation);
+        }
+    }
+}
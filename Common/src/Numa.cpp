@@ -0,0 +1,235 @@
+#include "../include/Numa.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <thread>
+#if defined(__linux__)
+#include <pthread.h>
+#include <sched.h>
+#include <unistd.h>
+#include <sys/syscall.h>
+#endif
+
+// Reads a whole sysfs file, empty when it does not exist
+static std::string readFile(const std::string& path){
+    std::string text;
+    FILE* file = std::fopen(path.c_str(), "r");
+    if (!file)
+        return text;
+    char buffer[4096];
+    size_t count;
+    while ((count = std::fread(buffer, 1, sizeof(buffer), file)) > 0)
+        text.append(buffer, count);
+    std::fclose(file);
+    return text;
+}
+
+// Parses a kernel cpu list such as "0-3,8,10-11"
+static std::vector<int> parseList(const std::string& text){
+    std::vector<int> values;
+    const char* p = text.c_str();
+    while (*p){
+        char* end;
+        long first = std::strtol(p, &end, 10);
+        if (end == p)
+            break;
+        long last = first;
+        p = end;
+        if (*p == '-'){
+            last = std::strtol(p + 1, &end, 10);
+            p = end;
+        }
+        for (long v = first; v <= last; v++)
+            values.push_back(static_cast<int>(v));
+        while (*p == ',' || *p == '\n' || *p == ' ')
+            p++;
+    }
+    return values;
+}
+
+Topology::Topology(){
+    const std::string base = "/sys/devices/system/cpu/";
+    std::vector<int> online = parseList(readFile(base + "online"));
+    for (size_t i = 0; i < online.size(); i++){
+        std::string dir = base + "cpu" + std::to_string(online[i]) + "/topology/";
+        std::string core = readFile(dir + "core_id");
+        std::string package = readFile(dir + "physical_package_id");
+        Cpu cpu = {online[i], online[i], 0, 0};
+        if (!core.empty())
+            cpu.core = std::atoi(package.c_str()) * 65536 + std::atoi(core.c_str());
+        cpus.push_back(cpu);
+    }
+    if (cpus.empty()){
+        int count = static_cast<int>(std::max(1u, std::thread::hardware_concurrency()));
+        for (int i = 0; i < count; i++){
+            Cpu cpu = {i, i, 0, 0};
+            cpus.push_back(cpu);
+        }
+    }
+
+    // Node directories may be sparse, so look a little past the last one found
+    for (int node = 0; node < 1024; node++){
+        std::string list = readFile("/sys/devices/system/node/node" + std::to_string(node) + "/cpulist");
+        if (list.empty())
+            continue;
+        std::vector<int> members = parseList(list);
+        for (size_t i = 0; i < cpus.size(); i++){
+            if (std::find(members.begin(), members.end(), cpus[i].id) != members.end())
+                cpus[i].node = node;
+        }
+    }
+
+    // Siblings are numbered by id within their core
+    for (size_t i = 0; i < cpus.size(); i++){
+        for (size_t j = 0; j < i; j++){
+            if (cpus[j].core == cpus[i].core)
+                cpus[i].sibling++;
+        }
+        if (std::find(nodeIds.begin(), nodeIds.end(), cpus[i].node) == nodeIds.end())
+            nodeIds.push_back(cpus[i].node);
+    }
+    std::sort(nodeIds.begin(), nodeIds.end());
+
+    for (size_t n = 0; n < nodeIds.size(); n++){
+        std::vector<Cpu> order;
+        for (size_t i = 0; i < cpus.size(); i++){
+            if (cpus[i].node == nodeIds[n])
+                order.push_back(cpus[i]);
+        }
+        std::stable_sort(order.begin(), order.end(), [](const Cpu& a, const Cpu& b){ return a.sibling < b.sibling; });
+        pinOrder.push_back(order);
+    }
+}
+
+const Topology& Topology::machine(){
+    static const Topology topology;
+    return topology;
+}
+
+int Topology::nodeOfCpu(int cpu) const {
+    for (size_t i = 0; i < cpus.size(); i++){
+        if (cpus[i].id == cpu)
+            return cpus[i].node;
+    }
+    return -1;
+}
+
+const Topology::Cpu& Topology::cpuForWorker(int worker, int workers) const {
+    int nodes = nodeCount();
+    int block = static_cast<int>(static_cast<long long>(worker) * nodes / workers);
+    // First worker of the block, the smallest w with w * nodes / workers == block
+    int first = static_cast<int>((static_cast<long long>(block) * workers + nodes - 1) / nodes);
+    const std::vector<Cpu>& order = pinOrder[block];
+    return order[(worker - first) % order.size()];
+}
+
+bool pinCurrentThread(int cpu){
+#if defined(__linux__)
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    CPU_SET(cpu, &set);
+    return pthread_setaffinity_np(pthread_self(), sizeof(set), &set) == 0;
+#else
+    (void)cpu;
+    return false;
+#endif
+}
+
+int currentCpu(){
+#if defined(__linux__)
+    return sched_getcpu();
+#else
+    return -1;
+#endif
+}
+
+std::vector<int> pageNodes(const void* data, size_t bytes){
+    std::vector<int> nodes;
+#if defined(__linux__) && defined(SYS_move_pages)
+    size_t pageSize = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+    uintptr_t first = reinterpret_cast<uintptr_t>(data) & ~(pageSize - 1);
+    uintptr_t end = reinterpret_cast<uintptr_t>(data) + bytes;
+    std::vector<void*> pages;
+    for (uintptr_t page = first; page < end; page += pageSize)
+        pages.push_back(reinterpret_cast<void*>(page));
+    nodes.assign(pages.size(), -1);
+    // With no target nodes move_pages() only reports where each page is, or a negative errno
+    if (!pages.empty() && syscall(SYS_move_pages, 0, pages.size(), pages.data(), nullptr, nodes.data(), 0) != 0)
+        std::fill(nodes.begin(), nodes.end(), -1);
+    for (size_t i = 0; i < nodes.size(); i++)
+        nodes[i] = std::max(nodes[i], -1);
+#else
+    (void)data;
+    (void)bytes;
+#endif
+    return nodes;
+}
+
+BandReading readBand(const Grid& grid, int rowStart, int rowEnd, int passes){
+    BandReading reading = {Topology::machine().nodeOfCpu(currentCpu()), 0, 0.0, 0, 0, 0};
+    if (rowStart >= rowEnd)
+        return reading;
+    const int8_t* start = grid.row(rowStart) - 1;
+    size_t bytes = static_cast<size_t>(rowEnd - rowStart) * grid.rowPitch();
+    std::vector<int> nodes = pageNodes(start, bytes);
+    reading.pages = nodes.size();
+    reading.localPages = static_cast<size_t>(std::count(nodes.begin(), nodes.end(), reading.node));
+
+    uint64_t sum = 0;
+    auto begin = std::chrono::steady_clock::now();
+    for (int pass = 0; pass < passes; pass++){
+        for (size_t i = 0; i + sizeof(uint64_t) <= bytes; i += sizeof(uint64_t)){
+            uint64_t word;
+            std::memcpy(&word, start + i, sizeof(word));
+            sum += word;
+        }
+    }
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - begin;
+    reading.checksum = sum;
+    reading.bytes = bytes * passes;
+    reading.seconds = elapsed.count();
+    return reading;
+}
+
+void printNodeReport(const std::vector<BandReading>& readings, const std::vector<const Grid*>& boards){
+    const Topology& topology = Topology::machine();
+    std::vector<size_t> boardPages(1024, 0);
+    size_t totalPages = 0;
+    for (size_t b = 0; b < boards.size(); b++){
+        const Grid& board = *boards[b];
+        std::vector<int> nodes = pageNodes(board.row(-1) - 1, static_cast<size_t>(board.numRows() + 2) * board.rowPitch());
+        for (size_t i = 0; i < nodes.size(); i++){
+            if (nodes[i] >= 0 && nodes[i] < 1024)
+                boardPages[nodes[i]]++;
+        }
+        totalPages += nodes.size();
+    }
+
+    std::cout << "NUMA: " << topology.nodeCount() << " node(s), " << topology.cpuCount() << " hardware threads\n";
+    for (int node = 0; node < 1024; node++){
+        int workers = 0;
+        size_t bytes = 0, pages = 0, localPages = 0;
+        double seconds = 0.0;
+        for (size_t i = 0; i < readings.size(); i++){
+            if (readings[i].node != node)
+                continue;
+            workers++;
+            bytes += readings[i].bytes;
+            pages += readings[i].pages;
+            localPages += readings[i].localPages;
+            // The node's workers read at the same time, so the slowest one sets the pace
+            seconds = std::max(seconds, readings[i].seconds);
+        }
+        if (workers == 0 && boardPages[node] == 0)
+            continue;
+        std::cout << "Node " << node << ": " << workers << " worker(s), "
+                  << (totalPages ? 100.0 * boardPages[node] / totalPages : 0.0) << "% of board pages, "
+                  << (pages ? 100.0 * localPages / pages : 0.0) << "% of band pages local, "
+                  << (seconds > 0.0 ? bytes / seconds / 1e9 : 0.0) << " GB/s\n";
+    }
+}
@@ -0,0 +1,213 @@
+#include "../include/Options.h"
+#include <iostream>
+#include <cstring>
+#include <cstdlib>
+#include <ctime>
+
+static bool parseEngine(const std::string& name, Engine& engine){
+    if (name == "scalar")
+        engine = Engine::Scalar;
+    else if (name == "simd")
+        engine = Engine::Simd;
+    else if (name == "bitplane")
+        engine = Engine::Bitplane;
+    else if (name == "packed")
+        engine = Engine::Packed;
+    else if (name == "window")
+        engine = Engine::Window;
+    else
+        return false;
+    return true;
+}
+
+static bool parseBoundary(const std::string& name, Boundary& boundary){
+    if (name == "dead")
+        boundary = Boundary::Dead;
+    else if (name == "torus")
+        boundary = Boundary::Torus;
+    else
+        return false;
+    return true;
+}
+
+static bool parseSchedule(const std::string& name, Schedule& schedule){
+    if (name == "static")
+        schedule = Schedule::Static;
+    else if (name == "cyclic")
+        schedule = Schedule::Cyclic;
+    else if (name == "steal")
+        schedule = Schedule::Steal;
+    else
+        return false;
+    return true;
+}
+
+static bool parsePartitioner(const std::string& name, Partitioner& partitioner){
+    if (name == "auto")
+        partitioner = Partitioner::Auto;
+    else if (name == "affinity")
+        partitioner = Partitioner::Affinity;
+    else if (name == "static")
+        partitioner = Partitioner::Static;
+    else
+        return false;
+    return true;
+}
+
+static bool parseSwitch(const std::string& text, bool& value){
+    if (text == "on")
+        value = true;
+    else if (text == "off")
+        value = false;
+    else
+        return false;
+    return true;
+}
+
+static bool parseNumber(const char* text, unsigned long long& value){
+    char* end = nullptr;
+    value = std::strtoull(text, &end, 0);
+    return end != text && *end == '\0' && text[0] != '-';
+}
+
+// Stores a whole number in [minValue, maxValue] into value, anything else is reported and keeps the default
+static void parseCount(const std::string& flag, const char* text, int minValue, int maxValue, int& value){
+    unsigned long long number;
+    if (parseNumber(text, number) && number >= static_cast<unsigned long long>(minValue) && number <= static_cast<unsigned long long>(maxValue))
+        value = static_cast<int>(number);
+    else
+        std::cerr << "Invalid value " << text << " for " << flag << ", expected " << minValue << " to " << maxValue << "\n";
+}
+
+Options parseOptions(int argc, char** argv){
+    Options options;
+    bool seedGiven = false;
+    for (int i = 1; i < argc; i++){
+        std::string flag = argv[i];
+        bool hasValue = i + 1 < argc;
+
+        if (flag == "--engine" && hasValue){
+            if (!parseEngine(argv[++i], options.engine))
+                std::cerr << "Unknown engine " << argv[i] << ", using " << engineName(options.engine) << "\n";
+        }
+        else if (flag == "--boundary" && hasValue){
+            if (!parseBoundary(argv[++i], options.boundary))
+                std::cerr << "Unknown boundary " << argv[i] << ", using " << boundaryName(options.boundary) << "\n";
+        }
+        else if (flag == "--seed" && hasValue){
+            unsigned long long value;
+            if (parseNumber(argv[++i], value)){
+                options.seed = value;
+                seedGiven = true;
+            }
+            else
+                std::cerr << "Invalid seed " << argv[i] << ", using the clock\n";
+        }
+        else if (flag == "--generations" && hasValue)
+            parseCount(flag, argv[++i], 1, 0x7FFFFFFF, options.generations);
+        else if (flag == "--fast-forward" && hasValue){
+            unsigned long long value;
+            if (parseNumber(argv[++i], value))
+                options.fastForward = value;
+            else
+                std::cerr << "Invalid value " << argv[i] << " for " << flag << ", expected a generation\n";
+        }
+        else if (flag == "--width" && hasValue)
+            parseCount(flag, argv[++i], 1, 1 << 20, options.width);
+        else if (flag == "--height" && hasValue)
+            parseCount(flag, argv[++i], 1, 1 << 20, options.height);
+        else if (flag == "--species" && hasValue)
+            parseCount(flag, argv[++i], 1, MaxSpecies, options.species);
+        else if (flag == "--threads" && hasValue)
+            parseCount(flag, argv[++i], 1, 1024, options.threads);
+        else if (flag == "--tile" && hasValue)
+            parseCount(flag, argv[++i], 1, 1 << 16, options.tile);
+        else if (flag == "--skip-stable" && hasValue){
+            if (!parseSwitch(argv[++i], options.skipStable))
+                std::cerr << "Invalid value " << argv[i] << " for " << flag << ", expected on or off\n";
+        }
+        else if (flag == "--schedule" && hasValue){
+            if (!parseSchedule(argv[++i], options.schedule))
+                std::cerr << "Unknown schedule " << argv[i] << ", using " << scheduleName(options.schedule) << "\n";
+        }
+        else if (flag == "--partitioner" && hasValue){
+            if (!parsePartitioner(argv[++i], options.partitioner))
+                std::cerr << "Unknown partitioner " << argv[i] << ", using " << partitionerName(options.partitioner) << "\n";
+        }
+        else if (flag == "--numa" && hasValue){
+            if (!parseSwitch(argv[++i], options.numa))
+                std::cerr << "Invalid value " << argv[i] << " for " << flag << ", expected on or off\n";
+        }
+        else if (flag == "--numa-report" && hasValue){
+            if (!parseSwitch(argv[++i], options.numaReport))
+                std::cerr << "Invalid value " << argv[i] << " for " << flag << ", expected on or off\n";
+        }
+        else if (flag == "--temporal" && hasValue){
+            std::string value = argv[++i];
+            if (value == "auto")
+                options.temporal = -1;
+            else if (value == "off")
+                options.temporal = 0;
+            else
+                parseCount(flag, argv[i], 1, 4096, options.temporal);
+        }
+        else if (flag == "--fused" && hasValue){
+            if (!parseSwitch(argv[++i], options.fused))
+                std::cerr << "Invalid value " << argv[i] << " for " << flag << ", expected on or off\n";
+        }
+        else if (flag == "--pipeline" && hasValue){
+            if (!parseSwitch(argv[++i], options.pipeline))
+                std::cerr << "Invalid value " << argv[i] << " for " << flag << ", expected on or off\n";
+        }
+        else if (flag == "--shader-palette" && hasValue){
+            if (!parseSwitch(argv[++i], options.shaderPalette))
+                std::cerr << "Invalid value " << argv[i] << " for " << flag << ", expected on or off\n";
+        }
+        else if (flag == "--pbo" && hasValue){
+            if (!parseSwitch(argv[++i], options.pixelBuffers))
+                std::cerr << "Invalid value " << argv[i] << " for " << flag << ", expected on or off\n";
+        }
+        else if (flag == "--headless")
+            options.headless = true;
+        else
+            std::cerr << "Ignoring unknown option " << flag << "\n";
+    }
+    if (!seedGiven)
+        options.seed = static_cast<uint64_t>(time(0));
+    // A headless run has no window to close, so it always ends after a set number of generations
+    if (options.headless && options.generations == 0){
+        options.generations = 1000;
+        std::cerr << "--headless without --generations, running " << options.generations << "\n";
+    }
+    return options;
+}
+
+const char* engineName(Engine engine){
+    switch (engine){
+        case Engine::Simd: return "simd";
+        case Engine::Bitplane: return "bitplane";
+        case Engine::Packed: return "packed";
+        case Engine::Window: return "window";
+        default: return "scalar";
+    }
+}
+
+const char* boundaryName(Boundary boundary){
+    return boundary == Boundary::Torus ? "torus" : "dead";
+}
+
+const char* scheduleName(Schedule schedule){
+    switch (schedule){
+        case Schedule::Static: return "static";
+        case Schedule::Cyclic: return "cyclic";
+        default: return "steal";
+    }
+}
+
+const char* partitionerName(Partitioner partitioner){
+    switch (partitioner){
+        case Partitioner::Auto: return "auto";
+        case Partitioner::Static: return "static";
+        default: return "affinity";
+    }
+}
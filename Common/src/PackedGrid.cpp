@@ -0,0 +1,155 @@
+#include "../include/PackedGrid.h"
+#include "../include/Options.h"
+#include "../include/Rng.h"
+#include <cstring>
+
+const uint64_t lowBits = 0x1111111111111111ULL;  // bit 0 of every nibble
+
+static int roundUp(int value, int multiple){
+    return (value + multiple - 1) / multiple * multiple;
+}
+
+// 1 in bit 0 of every nibble where a and b hold the same value
+static inline uint64_t equalNibbles(uint64_t a, uint64_t b){
+    uint64_t x = a ^ b;
+    x |= x >> 1;
+    x |= x >> 2;
+    return ~x & lowBits;
+}
+
+PackedGrid::PackedGrid(int rows, int cols) : rows(rows), cols(cols) {
+    words = (cols + CellsPerWord - 1) / CellsPerWord;
+    // 64 bytes in front of every row keep the first word aligned and hold the left ghost,
+    // one more word after the row holds the right ghost when cols is a multiple of 16
+    pitch = roundUp(8 + words + 1, 8);
+    if ((pitch * sizeof(uint64_t)) % 1024 == 0)
+        pitch += 8;
+
+    size_t count = static_cast<size_t>(rows + 2) * pitch;
+    storage = new uint64_t[count + 8];
+    uint64_t* aligned = reinterpret_cast<uint64_t*>((reinterpret_cast<uintptr_t>(storage) + 63) & ~static_cast<uintptr_t>(63));
+    std::memset(aligned, 0, count * sizeof(uint64_t));
+    origin = aligned + pitch + 8;
+}
+
+PackedGrid::~PackedGrid(){
+    delete [] storage;
+}
+
+int8_t PackedGrid::get(int r, int c) const {
+    uint64_t word = row(r)[c >> 4];
+    return static_cast<int8_t>(((word >> ((c & 15) * 4)) & 0xF) - 1);
+}
+
+void PackedGrid::set(int r, int c, int8_t state){
+    uint64_t& word = row(r)[c >> 4];
+    int shift = (c & 15) * 4;
+    word = (word & ~(0xFULL << shift)) | (static_cast<uint64_t>(state + 1) << shift);
+}
+
+void PackedGrid::refreshHalo(Boundary boundary){
+    for (int r = 0; r < rows; r++){
+        set(r, -1, boundary == Boundary::Torus ? get(r, cols - 1) : deadID);
+        set(r, cols, boundary == Boundary::Torus ? get(r, 0) : deadID);
+    }
+    if (boundary == Boundary::Torus){
+        std::memcpy(row(-1) - 1, row(rows - 1) - 1, (words + 2) * sizeof(uint64_t));
+        std::memcpy(row(rows) - 1, row(0) - 1, (words + 2) * sizeof(uint64_t));
+    }
+    else{
+        std::memset(row(-1) - 1, 0, (words + 2) * sizeof(uint64_t));
+        std::memset(row(rows) - 1, 0, (words + 2) * sizeof(uint64_t));
+    }
+}
+
+void PackedGrid::pack(const Grid& grid){
+    for (int r = 0; r < rows; r++){
+        uint64_t* packed = row(r);
+        const int8_t* cells = grid.row(r);
+        for (int w = 0; w < words; w++){
+            uint64_t word = 0;
+            for (int i = 0; i < CellsPerWord && w * CellsPerWord + i < cols; i++)
+                word |= static_cast<uint64_t>(cells[w * CellsPerWord + i] + 1) << (i * 4);
+            packed[w] = word;
+        }
+    }
+}
+
+void PackedGrid::unpack(Grid& grid) const {
+    for (int r = 0; r < rows; r++){
+        const uint64_t* packed = row(r);
+        int8_t* cells = grid.row(r);
+        for (int c = 0; c < cols; c++)
+            cells[c] = static_cast<int8_t>(((packed[c >> 4] >> ((c & 15) * 4)) & 0xF) - 1);
+    }
+}
+
+void stepRowsPacked(const PackedGrid& foreground, PackedGrid& background, int rowStart, int rowEnd, int colStart, int colEnd, int numSpecies, uint64_t seed, uint64_t generation){
+    const int cellsPerWord = PackedGrid::CellsPerWord;
+    int wordStart = (colStart + cellsPerWord - 1) / cellsPerWord;
+    int wordEnd = (colEnd + cellsPerWord - 1) / cellsPerWord;
+
+    for (int r = rowStart; r < rowEnd; r++){
+        const uint64_t* up = foreground.row(r - 1);
+        const uint64_t* mid = foreground.row(r);
+        const uint64_t* down = foreground.row(r + 1);
+        uint64_t* next = background.row(r);
+
+        for (int w = wordStart; w < wordEnd; w++){
+            // Shifting by a nibble and pulling one in from the next word lines every neighbour up with its cell
+            uint64_t around[8] = {
+                up[w],
+                down[w],
+                (mid[w] << 4) | (mid[w - 1] >> 60),
+                (mid[w] >> 4) | (mid[w + 1] << 60),
+                (up[w] << 4) | (up[w - 1] >> 60),
+                (up[w] >> 4) | (up[w + 1] << 60),
+                (down[w] << 4) | (down[w - 1] >> 60),
+                (down[w] >> 4) | (down[w + 1] << 60)
+            };
+            uint64_t center = mid[w];
+
+            uint64_t dead = equalNibbles(center, 0);
+            uint64_t same = 0;
+            for (int i = 0; i < 8; i++)
+                same += equalNibbles(around[i], center);
+            uint64_t survive = ~dead & lowBits & (equalNibbles(same, 2 * lowBits) | equalNibbles(same, 3 * lowBits));
+            uint64_t result = center & (survive * 0xF);
+
+            uint64_t candidates = 0;
+            uint64_t chosen = 0;
+            for (int s = 1; s <= numSpecies; s++){
+                uint64_t species = s * lowBits;
+                uint64_t count = 0;
+                for (int i = 0; i < 8; i++)
+                    count += equalNibbles(around[i], species);
+                uint64_t isThree = dead & equalNibbles(count, 3 * lowBits);
+                candidates += isThree;
+                chosen = (chosen & ~(isThree * 0xF)) | (species & (isThree * 0xF));
+            }
+
+            uint64_t ties = dead & ~(equalNibbles(candidates, 0) | equalNibbles(candidates, lowBits));
+            result |= chosen & ~(ties * 0xF);
+
+            while (ties){
+                int nibble = 0;
+                while (!((ties >> (nibble * 4)) & 1))
+                    nibble++;
+                int list[MaxSpecies];
+                int listCount = 0;
+                for (int s = 1; s <= numSpecies; s++){
+                    int count = 0;
+                    for (int i = 0; i < 8; i++)
+                        count += ((around[i] >> (nibble * 4)) & 0xF) == static_cast<uint64_t>(s);
+                    if (count == 3)
+                        list[listCount++] = s;
+                }
+                uint64_t pick = list[tieBreak(seed, generation, r, w * cellsPerWord + nibble, listCount)];
+                result |= pick << (nibble * 4);
+                ties &= ~(1ULL << (nibble * 4));
+            }
+
+            next[w] = result;
+        }
+    }
+}
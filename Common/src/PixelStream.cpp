@@ -0,0 +1,47 @@
+#include "../include/PixelStream.h"
+#include <iostream>
+
+PixelStream::PixelStream(GLuint texture, int width, int height, GLenum format, GLenum type, size_t bytesPerPixel)
+    : texture(texture), width(width), height(height), format(format), type(type),
+      bytes(static_cast<size_t>(width) * height * bytesPerPixel) {
+    glGenBuffers(Slots, buffers);
+    for (int slot = 0; slot < Slots; slot++){
+        glBindBuffer(GL_PIXEL_UNPACK_BUFFER, buffers[slot]);
+        glBufferData(GL_PIXEL_UNPACK_BUFFER, bytes, nullptr, GL_STREAM_DRAW);
+        fences[slot] = nullptr;
+    }
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+}
+
+PixelStream::~PixelStream(){
+    for (int slot = 0; slot < Slots; slot++){
+        if (fences[slot])
+            glDeleteSync(fences[slot]);
+    }
+    glDeleteBuffers(Slots, buffers);
+}
+
+void* PixelStream::map(int slot){
+    // The GL may still be copying this buffer's last image into the texture
+    if (fences[slot]){
+        while (glClientWaitSync(fences[slot], GL_SYNC_FLUSH_COMMANDS_BIT, 1000000000) == GL_TIMEOUT_EXPIRED) {}
+        glDeleteSync(fences[slot]);
+        fences[slot] = nullptr;
+    }
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, buffers[slot]);
+    void* image = glMapBufferRange(GL_PIXEL_UNPACK_BUFFER, 0, bytes, GL_MAP_WRITE_BIT | GL_MAP_UNSYNCHRONIZED_BIT);
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+    if (!image)
+        std::cerr << "Failed to map pixel buffer " << slot << "\n";
+    return image;
+}
+
+void PixelStream::upload(int slot){
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, buffers[slot]);
+    glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER);
+    glBindTexture(GL_TEXTURE_2D, texture);
+    // With a buffer bound the last argument is an offset into it
+    glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, width, height, format, type, nullptr);
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+    fences[slot] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+}
@@ -0,0 +1,113 @@
+#include "../include/SimdStep.h"
+#include "../include/Options.h"
+#include "../include/Rng.h"
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+SimdLevel detectSimdLevel(){
+#if defined(__x86_64__) || defined(__i386__)
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx512bw"))
+        return SimdLevel::AVX512;
+    if (__builtin_cpu_supports("avx2"))
+        return SimdLevel::AVX2;
+    return SimdLevel::SSE2;
+#elif defined(_M_X64) || defined(_M_IX86)
+    int info[4];
+    __cpuid(info, 0);
+    int maxLeaf = info[0];
+    __cpuid(info, 1);
+    // The OS has to save the wide registers too
+    bool osxsave = (info[2] & (1 << 27)) != 0;
+    unsigned long long xcr0 = osxsave ? _xgetbv(0) : 0;
+    if (maxLeaf < 7 || (xcr0 & 0x6) != 0x6)
+        return SimdLevel::SSE2;
+    __cpuidex(info, 7, 0);
+    if ((info[1] & (1 << 30)) && (info[1] & (1 << 16)) && (xcr0 & 0xE0) == 0xE0)
+        return SimdLevel::AVX512;
+    if (info[1] & (1 << 5))
+        return SimdLevel::AVX2;
+    return SimdLevel::SSE2;
+#else
+    return SimdLevel::Scalar;
+#endif
+}
+
+const char* simdLevelName(SimdLevel level){
+    switch (level){
+        case SimdLevel::AVX512: return "AVX-512";
+        case SimdLevel::AVX2: return "AVX2";
+        case SimdLevel::SSE2: return "SSE2";
+        default: return "scalar";
+    }
+}
+
+int8_t stepCellScalar(const int8_t* cell, const std::ptrdiff_t neighbors[8], int numSpecies, uint64_t seed, uint64_t generation, int row, int col){
+    int cellStatus = *cell;
+    int neighborCount = 0;
+    int speciesCounter[MaxSpecies + 1] = {0};
+
+    for (int i = 0; i < 8; i++){
+        int neighbor = cell[neighbors[i]];
+        neighborCount += (neighbor == cellStatus);
+        speciesCounter[neighbor + 1]++;
+    }
+
+    if (cellStatus == deadID){
+        int candidates[MaxSpecies];
+        int candidateCount = 0;
+        for (int s = 0; s < numSpecies; s++){
+            if (speciesCounter[s + 1] == 3)
+                candidates[candidateCount++] = s;
+        }
+        return candidateCount > 0 ? candidates[tieBreak(seed, generation, row, col, candidateCount)] : deadID;
+    }
+    return (neighborCount < 2 || neighborCount > 3) ? deadID : cellStatus;
+}
+
+void stepRowsScalar(const Grid& foreground, Grid& background, int rowStart, int rowEnd, int colStart, int colEnd, int numSpecies, uint64_t seed, uint64_t generation){
+    std::ptrdiff_t neighbors[8];
+    foreground.neighborOffsets(neighbors);
+
+    for (int row = rowStart; row < rowEnd; row++){
+        const int8_t* cells = foreground.row(row);
+        int8_t* next = background.row(row);
+        int boardRow = foreground.boardRow(row);
+        for (int col = colStart; col < colEnd; col++)
+            next[col] = stepCellScalar(cells + col, neighbors, numSpecies, seed, generation, boardRow, foreground.boardCol(col));
+    }
+}
+
+int8_t stepCellPass(const SimdPass& pass, int row, int col){
+    const int8_t* cell = pass.cells + row * pass.cellsPitch + col;
+    return stepCellScalar(cell, pass.neighbors, pass.numSpecies, pass.seed, pass.generation, pass.foreground->boardRow(row), pass.foreground->boardCol(col));
+}
+
+void stepRowsSimd(const Grid& foreground, Grid& background, int rowStart, int rowEnd, int colStart, int colEnd, int numSpecies, uint64_t seed, uint64_t generation, SimdLevel level){
+    if (level == SimdLevel::Scalar){
+        stepRowsScalar(foreground, background, rowStart, rowEnd, colStart, colEnd, numSpecies, seed, generation);
+        return;
+    }
+    SimdPass pass;
+    pass.foreground = &foreground;
+    pass.background = &background;
+    pass.cells = foreground.row(0);
+    pass.next = background.row(0);
+    pass.cellsPitch = foreground.rowPitch();
+    pass.nextPitch = background.rowPitch();
+    foreground.neighborOffsets(pass.neighbors);
+    pass.numSpecies = numSpecies;
+    pass.seed = seed;
+    pass.generation = generation;
+    switch (level){
+        case SimdLevel::AVX512: stepRowsAVX512(pass, rowStart, rowEnd, colStart, colEnd); break;
+        case SimdLevel::AVX2: stepRowsAVX2(pass, rowStart, rowEnd, colStart, colEnd); break;
+        default: stepRowsSSE2(pass, rowStart, rowEnd, colStart, colEnd); break;
+    }
+}
+
+void stepRowsSimd(const Grid& foreground, Grid& background, int rowStart, int rowEnd, int colStart, int colEnd, int numSpecies, uint64_t seed, uint64_t generation){
+    static const SimdLevel level = detectSimdLevel();
+    stepRowsSimd(foreground, background, rowStart, rowEnd, colStart, colEnd, numSpecies, seed, generation, level);
+}
@@ -0,0 +1,38 @@
+#include "SimdStepImpl.h"
+
+// Built with -mavx2 (/arch:AVX2), only called after detectSimdLevel() has checked the CPU
+#if defined(__AVX2__)
+#include <immintrin.h>
+
+namespace {
+
+struct AVX2 {
+    typedef __m256i reg;
+    typedef __m256i mask;
+    static const int width = 32;
+
+    static reg load(const int8_t* p) { return _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p)); }
+    static void store(int8_t* p, reg v) { _mm256_storeu_si256(reinterpret_cast<__m256i*>(p), v); }
+    static reg set1(int8_t v) { return _mm256_set1_epi8(v); }
+    static mask eq(reg a, reg b) { return _mm256_cmpeq_epi8(a, b); }
+    static reg inc(reg acc, mask m) { return _mm256_sub_epi8(acc, m); }
+    static reg blend(mask m, reg a, reg b) { return _mm256_blendv_epi8(b, a, m); }
+    static mask mor(mask a, mask b) { return _mm256_or_si256(a, b); }
+    static mask mandnot(mask a, mask b) { return _mm256_andnot_si256(a, b); }
+    static bool any(mask m) { return !_mm256_testz_si256(m, m); }
+    static uint64_t bits(mask m) { return static_cast<uint32_t>(_mm256_movemask_epi8(m)); }
+};
+
+}
+
+void stepRowsAVX2(const SimdPass& pass, int rowStart, int rowEnd, int colStart, int colEnd){
+    stepRowsVector<AVX2>(pass, rowStart, rowEnd, colStart, colEnd);
+}
+
+#else
+
+void stepRowsAVX2(const SimdPass& pass, int rowStart, int rowEnd, int colStart, int colEnd){
+    stepRowsSSE2(pass, rowStart, rowEnd, colStart, colEnd);
+}
+
+#endif
@@ -0,0 +1,38 @@
+#include "SimdStepImpl.h"
+
+// Built with -mavx512f -mavx512bw (/arch:AVX512), only called after detectSimdLevel() has checked the CPU
+#if defined(__AVX512BW__)
+#include <immintrin.h>
+
+namespace {
+
+struct AVX512 {
+    typedef __m512i reg;
+    typedef __mmask64 mask;
+    static const int width = 64;
+
+    static reg load(const int8_t* p) { return _mm512_loadu_si512(p); }
+    static void store(int8_t* p, reg v) { _mm512_storeu_si512(p, v); }
+    static reg set1(int8_t v) { return _mm512_set1_epi8(v); }
+    static mask eq(reg a, reg b) { return _mm512_cmpeq_epi8_mask(a, b); }
+    static reg inc(reg acc, mask m) { return _mm512_mask_add_epi8(acc, m, acc, _mm512_set1_epi8(1)); }
+    static reg blend(mask m, reg a, reg b) { return _mm512_mask_blend_epi8(m, b, a); }
+    static mask mor(mask a, mask b) { return a | b; }
+    static mask mandnot(mask a, mask b) { return ~a & b; }
+    static bool any(mask m) { return m != 0; }
+    static uint64_t bits(mask m) { return m; }
+};
+
+}
+
+void stepRowsAVX512(const SimdPass& pass, int rowStart, int rowEnd, int colStart, int colEnd){
+    stepRowsVector<AVX512>(pass, rowStart, rowEnd, colStart, colEnd);
+}
+
+#else
+
+void stepRowsAVX512(const SimdPass& pass, int rowStart, int rowEnd, int colStart, int colEnd){
+    stepRowsAVX2(pass, rowStart, rowEnd, colStart, colEnd);
+}
+
+#endif
@@ -0,0 +1,99 @@
+#pragma once
+#include "../include/SimdStep.h"
+#include <cstdint>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+// Shared body of the vector kernels. Each SimdStep<ISA>.cpp includes this with its own
+// register wrapper V. The helpers here are in an anonymous namespace, and the boards only
+// arrive as a SimdPass, so these files emit no copy of any inline function shared with the
+// rest of the program.
+namespace {
+
+inline int lowestBit(uint64_t bits){
+#if defined(_MSC_VER)
+    unsigned long index;
+    _BitScanForward64(&index, bits);
+    return static_cast<int>(index);
+#else
+    return __builtin_ctzll(bits);
+#endif
+}
+
+template <class V>
+void stepRowsVector(const SimdPass& pass, int rowStart, int rowEnd, int colStart, int colEnd){
+    typedef typename V::reg reg;
+    typedef typename V::mask mask;
+
+    const std::ptrdiff_t* neighbors = pass.neighbors;
+    int numSpecies = pass.numSpecies;
+
+    const reg dead = V::set1(deadID);
+    const reg zero = V::set1(0);
+    const reg one = V::set1(1);
+    const reg two = V::set1(2);
+    const reg three = V::set1(3);
+
+    for (int row = rowStart; row < rowEnd; row++){
+        const int8_t* cells = pass.cells + row * pass.cellsPitch;
+        int8_t* next = pass.next + row * pass.nextPitch;
+        int col = colStart;
+
+        for (; col < colEnd; col += V::width){
+            // A ragged tail is redone as the last full vector of the range, overlapping cells come out the same
+            if (col + V::width > colEnd){
+                if (colEnd - colStart < V::width)
+                    break;
+                col = colEnd - V::width;
+            }
+            const int8_t* cell = cells + col;
+            reg center = V::load(cell);
+            reg around[8];
+            for (int i = 0; i < 8; i++)
+                around[i] = V::load(cell + neighbors[i]);
+
+            // Survival, count the neighbours of the same species
+            reg same = zero;
+            for (int i = 0; i < 8; i++)
+                same = V::inc(same, V::eq(around[i], center));
+            mask survive = V::mor(V::eq(same, two), V::eq(same, three));
+            reg result = V::blend(survive, center, dead);
+
+            mask isDead = V::eq(center, dead);
+            if (!V::any(isDead)){
+                V::store(next + col, result);
+                continue;
+            }
+
+            // Birth, a species is a candidate when exactly 3 neighbours belong to it
+            reg chosen = dead;
+            reg candidateCount = zero;
+            for (int s = 0; s < numSpecies; s++){
+                reg species = V::set1(static_cast<int8_t>(s));
+                reg count = zero;
+                for (int i = 0; i < 8; i++)
+                    count = V::inc(count, V::eq(around[i], species));
+                mask isThree = V::eq(count, three);
+                candidateCount = V::inc(candidateCount, isThree);
+                chosen = V::blend(isThree, species, chosen);
+            }
+            result = V::blend(isDead, chosen, result);
+            V::store(next + col, result);
+
+            // Ties are rare, settle them with the scalar rule
+            mask single = V::mor(V::eq(candidateCount, zero), V::eq(candidateCount, one));
+            uint64_t ties = V::bits(V::mandnot(single, isDead));
+            while (ties){
+                int lane = lowestBit(ties);
+                next[col + lane] = stepCellPass(pass, row, col + lane);
+                ties &= ties - 1;
+            }
+        }
+
+        for (; col < colEnd; col++)
+            next[col] = stepCellPass(pass, row, col);
+    }
+}
+
+}
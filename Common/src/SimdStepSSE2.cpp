@@ -0,0 +1,38 @@
+#include "SimdStepImpl.h"
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#include <emmintrin.h>
+
+namespace {
+
+struct SSE2 {
+    typedef __m128i reg;
+    typedef __m128i mask;
+    static const int width = 16;
+
+    static reg load(const int8_t* p) { return _mm_loadu_si128(reinterpret_cast<const __m128i*>(p)); }
+    static void store(int8_t* p, reg v) { _mm_storeu_si128(reinterpret_cast<__m128i*>(p), v); }
+    static reg set1(int8_t v) { return _mm_set1_epi8(v); }
+    static mask eq(reg a, reg b) { return _mm_cmpeq_epi8(a, b); }
+    // Compare masks are -1 per lane, subtracting them counts the hits
+    static reg inc(reg acc, mask m) { return _mm_sub_epi8(acc, m); }
+    static reg blend(mask m, reg a, reg b) { return _mm_or_si128(_mm_and_si128(m, a), _mm_andnot_si128(m, b)); }
+    static mask mor(mask a, mask b) { return _mm_or_si128(a, b); }
+    static mask mandnot(mask a, mask b) { return _mm_andnot_si128(a, b); }
+    static bool any(mask m) { return _mm_movemask_epi8(m) != 0; }
+    static uint64_t bits(mask m) { return static_cast<uint32_t>(_mm_movemask_epi8(m)); }
+};
+
+}
+
+void stepRowsSSE2(const SimdPass& pass, int rowStart, int rowEnd, int colStart, int colEnd){
+    stepRowsVector<SSE2>(pass, rowStart, rowEnd, colStart, colEnd);
+}
+
+#else
+
+void stepRowsSSE2(const SimdPass& pass, int rowStart, int rowEnd, int colStart, int colEnd){
+    stepRowsScalar(*pass.foreground, *pass.background, rowStart, rowEnd, colStart, colEnd, pass.numSpecies, pass.seed, pass.generation);
+}
+
+#endif
@@ -0,0 +1,111 @@
+#include "../include/TemporalTiles.h"
+#include "../include/SimdStep.h"
+#include "../include/WindowStep.h"
+#include <algorithm>
+#include <cstring>
+#if defined(__unix__) || defined(__APPLE__)
+#include <unistd.h>
+#endif
+
+TemporalTiles::TemporalTiles(int rows, int cols, int tileSize, int depth, Boundary boundary, Engine engine) : rows(rows), cols(cols), tileSize(tileSize), depth(depth), boundary(boundary), engine(engine) {
+    tileRows = (rows + tileSize - 1) / tileSize;
+    tileCols = (cols + tileSize - 1) / tileSize;
+}
+
+size_t TemporalTiles::cacheSize(){
+#if defined(_SC_LEVEL2_CACHE_SIZE)
+    long bytes = sysconf(_SC_LEVEL2_CACHE_SIZE);
+    if (bytes > 0)
+        return static_cast<size_t>(bytes);
+#endif
+    return 1 << 20;
+}
+
+void TemporalTiles::pickSizes(size_t cacheBytes, int& tileSize, int& depth){
+    // Largest window edge whose two grids, with their padded rows, fit in half the cache
+    int window = 16;
+    while (2 * static_cast<size_t>(window + 16) * (window + 16 + 2 * Grid::Alignment) <= cacheBytes / 2)
+        window += 16;
+    if (tileSize <= 0){
+        depth = std::max(1, window / 16);
+        tileSize = std::max(1, window - 2 * depth);
+    }
+    else
+        depth = std::max(1, std::min((window - tileSize) / 2, tileSize / 8));
+}
+
+// Copies count cells of board row boardRow starting at column col into dst, wrapping around the columns
+static void copyRow(const Grid& board, int boardRow, int col, int count, int8_t* dst){
+    const int8_t* src = board.row(boardRow);
+    for (int j = 0; j < count;){
+        int c = Grid::wrap(col + j, board.numCols());
+        int run = std::min(count - j, board.numCols() - c);
+        std::memcpy(dst + j, src + c, run);
+        j += run;
+    }
+}
+
+// Dead cells around the first height x width cells of a window, where it meets the dead border
+static void clearFrame(Grid& window, int height, int width){
+    std::memset(window.row(-1) - 1, deadID, width + 2);
+    std::memset(window.row(height) - 1, deadID, width + 2);
+    for (int r = 0; r < height; r++){
+        window.row(r)[-1] = deadID;
+        window.row(r)[width] = deadID;
+    }
+}
+
+void TemporalTiles::advanceTile(const Grid& foreground, Grid& background, int tile, int generations, int numSpecies, uint64_t seed, uint64_t generation, Scratch& scratch) const {
+    int rowStart = (tile / tileCols) * tileSize;
+    int colStart = (tile % tileCols) * tileSize;
+    int rowEnd = std::min(rowStart + tileSize, rows);
+    int colEnd = std::min(colStart + tileSize, cols);
+
+    // The window reaches a cell further out per generation, the dead border cuts it off and the torus wraps it
+    int top = rowStart - generations, bottom = rowEnd + generations;
+    int left = colStart - generations, right = colEnd + generations;
+    bool edgeTop = false, edgeBottom = false, edgeLeft = false, edgeRight = false;
+    if (boundary == Boundary::Dead){
+        edgeTop = top <= 0;
+        edgeBottom = bottom >= rows;
+        edgeLeft = left <= 0;
+        edgeRight = right >= cols;
+        top = std::max(top, 0);
+        bottom = std::min(bottom, rows);
+        left = std::max(left, 0);
+        right = std::min(right, cols);
+    }
+    int height = bottom - top;
+    int width = right - left;
+
+    int windowEdge = tileSize + 2 * depth;
+    if (!scratch.current || scratch.current->numRows() < windowEdge){
+        scratch.current.reset(new Grid(windowEdge, windowEdge));
+        scratch.next.reset(new Grid(windowEdge, windowEdge));
+    }
+    Grid* current = scratch.current.get();
+    Grid* next = scratch.next.get();
+    current->placeOnBoard(top, left, rows, cols);
+    next->placeOnBoard(top, left, rows, cols);
+    clearFrame(*current, height, width);
+    clearFrame(*next, height, width);
+    for (int r = 0; r < height; r++)
+        copyRow(foreground, Grid::wrap(top + r, rows), left, width, current->row(r));
+
+    for (int s = 1; s <= generations; s++){
+        int r0 = edgeTop ? 0 : s;
+        int r1 = edgeBottom ? height : height - s;
+        int c0 = edgeLeft ? 0 : s;
+        int c1 = edgeRight ? width : width - s;
+        if (engine == Engine::Simd)
+            stepRowsSimd(*current, *next, r0, r1, c0, c1, numSpecies, seed, generation + s - 1);
+        else if (engine == Engine::Window)
+            stepRowsWindow(*current, *next, r0, r1, c0, c1, numSpecies, seed, generation + s - 1);
+        else
+            stepRowsScalar(*current, *next, r0, r1, c0, c1, numSpecies, seed, generation + s - 1);
+        std::swap(current, next);
+    }
+
+    for (int r = rowStart; r < rowEnd; r++)
+        std::memcpy(background.row(r) + colStart, current->row(r - top) + (colStart - left), colEnd - colStart);
+}
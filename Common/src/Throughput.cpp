@@ -0,0 +1,44 @@
+#include "../include/Throughput.h"
+#include <algorithm>
+#include <cstdio>
+
+void StepTimes::add(double stepSeconds, int stepGenerations){
+    seconds.push_back(stepSeconds);
+    generations.push_back(stepGenerations);
+}
+
+uint64_t StepTimes::generationCount() const {
+    uint64_t count = 0;
+    for (size_t i = 0; i < generations.size(); i++)
+        count += generations[i];
+    return count;
+}
+
+double StepTimes::totalSeconds() const {
+    double total = 0.0;
+    for (size_t i = 0; i < seconds.size(); i++)
+        total += seconds[i];
+    return total;
+}
+
+double StepTimes::percentile(double fraction) const {
+    if (seconds.empty())
+        return 0.0;
+    std::vector<double> perGeneration(seconds.size());
+    for (size_t i = 0; i < seconds.size(); i++)
+        perGeneration[i] = seconds[i] / generations[i];
+    std::sort(perGeneration.begin(), perGeneration.end());
+    // Nearest rank
+    size_t rank = static_cast<size_t>(fraction * perGeneration.size() + 0.5);
+    return perGeneration[std::min(perGeneration.size() - 1, rank > 0 ? rank - 1 : 0)];
+}
+
+void printThroughput(const StepTimes& steps, int rows, int cols){
+    uint64_t generations = steps.generationCount();
+    double seconds = steps.totalSeconds();
+    double perSecond = seconds > 0.0 ? generations / seconds : 0.0;
+    double mean = generations > 0 ? seconds / generations : 0.0;
+    std::printf("Headless: %llu generations in %.3f s, %.1f generations/s, %.4g cells/s, step mean %.4f ms p50 %.4f ms p99 %.4f ms\n",
+                static_cast<unsigned long long>(generations), seconds, perSecond, perSecond * rows * cols,
+                1000.0 * mean, 1000.0 * steps.percentile(0.5), 1000.0 * steps.percentile(0.99));
+}
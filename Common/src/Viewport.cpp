@@ -0,0 +1,42 @@
+#include "../include/Viewport.h"
+#include <cstdint>
+
+void fitInside(int cols, int rows, int maxWidth, int maxHeight, bool grow, int& width, int& height){
+    if (!grow && cols <= maxWidth && rows <= maxHeight){
+        width = cols;
+        height = rows;
+        return;
+    }
+    // Scale by the tighter of the two limits, in 64 bits so 1M x 1M boards do not overflow
+    if (static_cast<int64_t>(cols) * maxHeight >= static_cast<int64_t>(rows) * maxWidth){
+        width = maxWidth;
+        height = static_cast<int>(static_cast<int64_t>(rows) * maxWidth / cols);
+    }
+    else{
+        height = maxHeight;
+        width = static_cast<int>(static_cast<int64_t>(cols) * maxHeight / rows);
+    }
+    if (width < 1)
+        width = 1;
+    if (height < 1)
+        height = 1;
+}
+
+std::vector<int> sampleIndices(int count, int displayCount){
+    std::vector<int> indices(displayCount);
+    for (int i = 0; i < displayCount; i++)
+        indices[i] = static_cast<int>(static_cast<int64_t>(i) * count / displayCount);
+    return indices;
+}
+
+std::vector<int> tileStarts(const std::vector<int>& samples, int tileSize, int tileCount){
+    std::vector<int> starts(tileCount + 1);
+    int index = 0;
+    for (int t = 0; t <= tileCount; t++){
+        while (index < static_cast<int>(samples.size()) && samples[index] < t * tileSize)
+            index++;
+        starts[t] = index;
+    }
+    starts[tileCount] = static_cast<int>(samples.size());
+    return starts;
+}
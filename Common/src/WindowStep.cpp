@@ -0,0 +1,109 @@
+#include "../include/WindowStep.h"
+#include "../include/Rng.h"
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+// Counter of state s sits at bits 4 * (s + 1), dead cells in the lowest one. A neighbourhood holds at
+// most 9 of a state, so no counter ever carries into the next.
+static const uint64_t OneHot[11] = {
+    1ULL << 0, 1ULL << 4, 1ULL << 8, 1ULL << 12, 1ULL << 16, 1ULL << 20,
+    1ULL << 24, 1ULL << 28, 1ULL << 32, 1ULL << 36, 1ULL << 40
+};
+static const uint64_t Threes = 0x3333333333333333ULL;
+static const uint64_t LowBits = 0x7777777777777777ULL;
+
+static inline uint64_t oneHot(int8_t cell){
+    return OneHot[cell + 1];
+}
+
+static inline int lowestBit(uint64_t bits){
+#if defined(_MSC_VER)
+    unsigned long index;
+    _BitScanForward64(&index, bits);
+    return static_cast<int>(index);
+#else
+    return __builtin_ctzll(bits);
+#endif
+}
+
+static inline int bitCount(uint64_t bits){
+#if defined(_MSC_VER)
+    return static_cast<int>(__popcnt64(bits));
+#else
+    return __builtin_popcountll(bits);
+#endif
+}
+
+// Next state of a cell from the counters of its 3 x 3 block, itself included
+static inline int8_t decideCell(uint64_t block, int8_t cell, uint64_t speciesMask, uint64_t seed, uint64_t generation, int row, int col){
+    uint64_t around = block - oneHot(cell);
+    if (cell != deadID){
+        int same = static_cast<int>((around >> ((cell + 1) * 4)) & 0xF);
+        return (same == 2 || same == 3) ? cell : static_cast<int8_t>(deadID);
+    }
+
+    // Top bit of every counter that holds exactly 3, the low bits can not carry into it
+    uint64_t diff = around ^ Threes;
+    uint64_t three = ~(((diff & LowBits) + LowBits) | diff | LowBits) & speciesMask;
+    if (!three)
+        return deadID;
+    // Candidates come out in ascending species order, as in every other engine
+    int candidateCount = bitCount(three);
+    if (candidateCount > 1){
+        int pick = tieBreak(seed, generation, row, col, candidateCount);
+        for (int i = 0; i < pick; i++)
+            three &= three - 1;
+    }
+    return static_cast<int8_t>(lowestBit(three) / 4 - 1);
+}
+
+// Rows r and, with Pair, r + 1. Column sums of rows r - 1 .. r + 1 and r .. r + 2 share rows r and r + 1.
+template <bool Pair>
+static void stepRows(const Grid& foreground, Grid& background, int r, int colStart, int colEnd, uint64_t speciesMask, uint64_t seed, uint64_t generation){
+    const int8_t* above = foreground.row(r - 1);
+    const int8_t* upper = foreground.row(r);
+    const int8_t* lower = foreground.row(r + 1);
+    const int8_t* below = Pair ? foreground.row(r + 2) : lower;
+    int8_t* nextUpper = background.row(r);
+    int8_t* nextLower = Pair ? background.row(r + 1) : nullptr;
+    int upperRow = foreground.boardRow(r);
+    int lowerRow = foreground.boardRow(r + 1);
+
+    uint64_t shared = oneHot(upper[colStart - 1]) + oneHot(lower[colStart - 1]);
+    uint64_t upperLeft = shared + oneHot(above[colStart - 1]);
+    uint64_t lowerLeft = shared + oneHot(below[colStart - 1]);
+    shared = oneHot(upper[colStart]) + oneHot(lower[colStart]);
+    uint64_t upperCentre = shared + oneHot(above[colStart]);
+    uint64_t lowerCentre = shared + oneHot(below[colStart]);
+
+    for (int c = colStart; c < colEnd; c++){
+        shared = oneHot(upper[c + 1]) + oneHot(lower[c + 1]);
+        uint64_t upperRight = shared + oneHot(above[c + 1]);
+        int col = foreground.boardCol(c);
+        nextUpper[c] = decideCell(upperLeft + upperCentre + upperRight, upper[c], speciesMask, seed, generation, upperRow, col);
+        upperLeft = upperCentre;
+        upperCentre = upperRight;
+        if (Pair){
+            uint64_t lowerRight = shared + oneHot(below[c + 1]);
+            nextLower[c] = decideCell(lowerLeft + lowerCentre + lowerRight, lower[c], speciesMask, seed, generation, lowerRow, col);
+            lowerLeft = lowerCentre;
+            lowerCentre = lowerRight;
+        }
+    }
+}
+
+void stepRowsWindow(const Grid& foreground, Grid& background, int rowStart, int rowEnd, int colStart, int colEnd, int numSpecies, uint64_t seed, uint64_t generation){
+    if (colStart >= colEnd)
+        return;
+    // Top bits of the counters of species 0 .. numSpecies - 1
+    uint64_t speciesMask = 0;
+    for (int s = 0; s < numSpecies; s++)
+        speciesMask |= 8ULL << ((s + 1) * 4);
+
+    int r = rowStart;
+    for (; r + 1 < rowEnd; r += 2)
+        stepRows<true>(foreground, background, r, colStart, colEnd, speciesMask, seed, generation);
+    if (r < rowEnd)
+        stepRows<false>(foreground, background, r, colStart, colEnd, speciesMask, seed, generation);
+}